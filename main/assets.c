@@ -0,0 +1,187 @@
+#include <string.h>
+#include <inttypes.h>
+
+#include "esp_log.h"
+
+#include "assets.h"
+
+#define TAG "ASSETS"
+
+/**
+ * @brief FNV-1a hash of a name, as tools/assetpack.py computes it
+ *
+ * @param name
+ * @return uint32_t
+ */
+uint32_t lcdAssetsHash(const char *name)
+{
+    uint32_t hash = 2166136261u;
+    for (const uint8_t *p = (const uint8_t *)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Check a pack before anything is read through its offsets
+ *
+ * @param base first byte of the pack
+ * @param size bytes mapped
+ * @return false when the pack is missing, damaged or larger than size
+ */
+static bool assets_valid(const uint8_t *base, uint32_t size)
+{
+    const lcd_assets_header_t *header = (const lcd_assets_header_t *)base;
+    if (size < sizeof(lcd_assets_header_t)) return false;
+    if (memcmp(header->magic, LCD_ASSETS_MAGIC, sizeof(header->magic)) != 0) return false;
+    if (header->size > size || header->size < sizeof(lcd_assets_header_t)) return false;
+    if (header->slots == 0 || (header->slots & (header->slots - 1)) != 0) return false;
+    if (header->count > header->slots) return false;
+    if ((uint64_t)header->slots * sizeof(lcd_assets_entry_t) > header->size - sizeof(lcd_assets_header_t)) return false;
+
+    const lcd_assets_entry_t *index = (const lcd_assets_entry_t *)(base + sizeof(lcd_assets_header_t));
+    for (uint32_t i = 0; i < header->slots; i++) {
+        const lcd_assets_entry_t *entry = &index[i];
+        if (entry->offset == 0) continue;
+        if (entry->offset > header->size || entry->size > header->size - entry->offset) return false;
+        if (entry->name >= header->size) return false;
+        if (memchr(base + entry->name, '\0', header->size - entry->name) == NULL) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Map the asset pack of a data partition. The pack stays in flash, blobs are read in place.
+ *
+ * @param assets
+ * @param label partition name in partitions.csv
+ * @return esp_err_t ESP_ERR_NOT_FOUND without the partition, ESP_ERR_INVALID_STATE when it
+ * holds no valid pack, or the error of esp_partition_mmap()
+ */
+esp_err_t lcdAssetsOpen(lcd_assets_t *assets, const char *label)
+{
+    memset(assets, 0, sizeof(lcd_assets_t));
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "Partition %s not found", label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const void *base;
+    esp_partition_mmap_handle_t handle;
+    esp_err_t ret = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &base, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Mapping %s failed: %s", label, esp_err_to_name(ret));
+        return ret;
+    }
+    if (!assets_valid(base, partition->size)) {
+        ESP_LOGE(TAG, "Partition %s holds no asset pack", label);
+        esp_partition_munmap(handle);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    assets->base = base;
+    assets->header = base;
+    assets->index = (const lcd_assets_entry_t *)(assets->base + sizeof(lcd_assets_header_t));
+    assets->handle = handle;
+    ESP_LOGI(TAG, "%s: %"PRIu32" assets, %"PRIu32" bytes", label, assets->header->count, assets->header->size);
+    return ESP_OK;
+}
+
+/**
+ * @brief Unmap the pack. Pointers returned for it, including fonts, must no longer be used.
+ *
+ * @param assets
+ */
+void lcdAssetsClose(lcd_assets_t *assets)
+{
+    if (assets->base == NULL) return;
+    esp_partition_munmap(assets->handle);
+    memset(assets, 0, sizeof(lcd_assets_t));
+}
+
+/**
+ * @brief Look up a blob by name, e.g. "ILGH16XB.FNT"
+ *
+ * @param assets
+ * @param name file name the blob was packed from
+ * @param size set to the bytes of the blob, may be NULL
+ * @param type set to the kind of the blob, may be NULL
+ * @return const void* the blob in flash, NULL when the pack has no such name
+ */
+const void *lcdAssetsFind(const lcd_assets_t *assets, const char *name, uint32_t *size, lcd_asset_type_t *type)
+{
+    if (assets->base == NULL) return NULL;
+    uint32_t hash = lcdAssetsHash(name);
+    uint32_t mask = assets->header->slots - 1;
+    for (uint32_t i = 0; i <= mask; i++) {
+        const lcd_assets_entry_t *entry = &assets->index[(hash + i) & mask];
+        if (entry->offset == 0) break;
+        if (entry->hash != hash) continue;
+        if (strcmp((const char *)assets->base + entry->name, name) != 0) continue;
+        if (size) *size = entry->size;
+        if (type) *type = entry->type;
+        return assets->base + entry->offset;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Open one font of the pack, or leave fx without a font for a NULL name
+ */
+static esp_err_t assets_font(const lcd_assets_t *assets, FontxFile *fx, const char *name)
+{
+    if (name == NULL) {
+        AddFontxEmbedded(fx, NULL);
+        return ESP_OK;
+    }
+    uint32_t size;
+    lcd_asset_type_t type;
+    const uint8_t *data = lcdAssetsFind(assets, name, &size, &type);
+    if (data == NULL || type != LCD_ASSET_FONT) {
+        ESP_LOGE(TAG, "Font %s not found", name);
+        AddFontxEmbedded(fx, NULL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!AddFontxMemory(fx, name, data, size)) return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+/**
+ * @brief InitFontx() for fonts of the pack. Glyphs are read from flash, the fonts stay
+ * usable until lcdAssetsClose().
+ *
+ * @param assets
+ * @param fxs two fonts, as for InitFontx()
+ * @param f0 name of the first font
+ * @param f1 name of the second font, may be NULL
+ * @return esp_err_t ESP_ERR_NOT_FOUND when a font is not in the pack, ESP_ERR_INVALID_ARG
+ * when it cannot be drawn
+ */
+esp_err_t lcdAssetsInitFont(const lcd_assets_t *assets, FontxFile *fxs, const char *f0, const char *f1)
+{
+    esp_err_t ret0 = assets_font(assets, &fxs[0], f0);
+    esp_err_t ret1 = assets_font(assets, &fxs[1], f1);
+    return ret0 != ESP_OK ? ret0 : ret1;
+}
+
+/**
+ * @brief Look up a bitmap, for lcdDrawPixelsDMA() or lcdDrawPixelsDMAWait(dev, x, y,
+ * bitmap->width, bitmap->height, bitmap->pixels). The SPI driver copies the colors out of
+ * flash, which DMA cannot read.
+ *
+ * @param assets
+ * @param name file name of the .bmp it was converted from
+ * @return const lcd_asset_bitmap_t* NULL when the pack has no such bitmap
+ */
+const lcd_asset_bitmap_t *lcdAssetsBitmap(const lcd_assets_t *assets, const char *name)
+{
+    uint32_t size;
+    lcd_asset_type_t type;
+    const lcd_asset_bitmap_t *bitmap = lcdAssetsFind(assets, name, &size, &type);
+    if (bitmap == NULL || type != LCD_ASSET_BITMAP) return NULL;
+    if (size < sizeof(lcd_asset_bitmap_t)) return NULL;
+    if ((size - sizeof(lcd_asset_bitmap_t)) / 2 < (uint32_t)bitmap->width * bitmap->height) return NULL;
+    return bitmap;
+}
@@ -0,0 +1,77 @@
+#ifndef MAIN_ASSETS_H_
+#define MAIN_ASSETS_H_
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+#include "esp_idf_version.h"
+#include "fontx.h"
+
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 0, 0)
+// esp-idf v4.4 maps partitions with the spi_flash types
+typedef spi_flash_mmap_handle_t esp_partition_mmap_handle_t;
+#define ESP_PARTITION_MMAP_DATA SPI_FLASH_MMAP_DATA
+#define esp_partition_munmap spi_flash_munmap
+#endif
+
+#define LCD_ASSETS_MAGIC	"AST1"
+#define LCD_ASSETS_ALIGN	16	// Blobs start on this boundary in the pack
+
+/**
+ * @brief Kind of a blob, from its file name extension when the pack was built
+ */
+typedef enum {
+	LCD_ASSET_RAW,      ///< Stored as it was
+	LCD_ASSET_FONT,     ///< FONTX .fnt file
+	LCD_ASSET_BITMAP,   ///< lcd_asset_bitmap_t, converted from a .bmp
+	LCD_ASSET_PALETTE,  ///< Big-endian RGB565 colors, the byte order of lcd_asset_bitmap_t
+} lcd_asset_type_t;
+
+/**
+ * @brief Start of a pack, followed by the index of `slots` entries
+ */
+typedef struct {
+	char magic[4];      ///< LCD_ASSETS_MAGIC
+	uint32_t slots;     ///< Index entries, a power of two
+	uint32_t count;     ///< Entries in use
+	uint32_t size;      ///< Bytes of the whole pack
+} lcd_assets_header_t;
+
+/**
+ * @brief Index entry. The slot of a name is its hash modulo the slot count, collisions go
+ * to the next free slot.
+ */
+typedef struct {
+	uint32_t hash;      ///< lcdAssetsHash() of the name
+	uint32_t name;      ///< Pack offset of the name, zero-terminated
+	uint32_t offset;    ///< Pack offset of the blob, 0 for a free slot
+	uint32_t size;      ///< Bytes of the blob
+	uint32_t type;      ///< lcd_asset_type_t
+} lcd_assets_entry_t;
+
+/**
+ * @brief Header of a LCD_ASSET_BITMAP blob, the colors follow row by row
+ */
+typedef struct {
+	uint16_t width;
+	uint16_t height;
+	uint16_t pixels[];  ///< Big-endian RGB565, as lcdDrawPixelsDMA() takes them
+} lcd_asset_bitmap_t;
+
+/**
+ * @brief Asset pack mapped from its partition
+ */
+typedef struct {
+	const uint8_t *base;
+	const lcd_assets_header_t *header;
+	const lcd_assets_entry_t *index;
+	esp_partition_mmap_handle_t handle;
+} lcd_assets_t;
+
+uint32_t lcdAssetsHash(const char *name);
+esp_err_t lcdAssetsOpen(lcd_assets_t *assets, const char *label);
+void lcdAssetsClose(lcd_assets_t *assets);
+const void *lcdAssetsFind(const lcd_assets_t *assets, const char *name, uint32_t *size, lcd_asset_type_t *type);
+esp_err_t lcdAssetsInitFont(const lcd_assets_t *assets, FontxFile *fxs, const char *f0, const char *f1);
+const lcd_asset_bitmap_t *lcdAssetsBitmap(const lcd_assets_t *assets, const char *name);
+#endif /* MAIN_ASSETS_H_ */
@@ -0,0 +1,288 @@
+#include <string.h>
+
+#include "esp_log.h"
+
+#include "canvas.h"
+
+#define TAG "CANVAS"
+
+/**
+ * @brief Part of canvas rectangle x1,y1..x2,y2 (inclusive, may lie outside the canvas) on a panel
+ *
+ * @param panel
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ * @param local set to the part in panel coordinates
+ * @return false when the rectangle misses the panel
+ */
+static bool canvas_clip(const lcd_canvas_panel_t *panel, int x1, int y1, int x2, int y2, lcd_rect_t *local)
+{
+    int px2 = panel->x + panel->dev->_width - 1;
+    int py2 = panel->y + panel->dev->_height - 1;
+    if (x1 < panel->x) x1 = panel->x;
+    if (y1 < panel->y) y1 = panel->y;
+    if (x2 > px2) x2 = px2;
+    if (y2 > py2) y2 = py2;
+    if (x1 > x2 || y1 > y2) return false;
+
+    local->x1 = x1 - panel->x;
+    local->y1 = y1 - panel->y;
+    local->x2 = x2 - panel->x;
+    local->y2 = y2 - panel->y;
+    return true;
+}
+
+/**
+ * @brief Span sink of the canvas: fill a canvas rectangle on every panel it touches
+ *
+ * @param canvas lcd_canvas_t
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ * @param color
+ */
+static void canvas_fill(void *canvas, int x1, int y1, int x2, int y2, uint16_t color)
+{
+    lcd_canvas_t *_canvas = canvas;
+    lcd_rect_t local;
+    for (uint8_t i = 0; i < _canvas->panelCount; i++) {
+        if (canvas_clip(&_canvas->panel[i], x1, y1, x2, y2, &local)) {
+            lcdDrawFillRect(_canvas->panel[i].dev, local.x1, local.y1, local.x2 - local.x1 + 1, local.y2 - local.y1 + 1, color);
+        }
+    }
+}
+
+/**
+ * @brief Set the panels up. Each one is turned to its rotation, the canvas extends to the
+ * right and bottom edges of the outermost panels.
+ *
+ * @param canvas
+ * @param panels
+ * @param count
+ * @return esp_err_t ESP_ERR_INVALID_ARG for too many panels, or the error of lcdSetOrientation()
+ */
+esp_err_t lcdCanvasInit(lcd_canvas_t *canvas, const lcd_canvas_panel_t *panels, uint8_t count)
+{
+    if (count == 0 || count > LCD_CANVAS_PANELS_MAX) return ESP_ERR_INVALID_ARG;
+
+    canvas->panelCount = count;
+    canvas->width = 0;
+    canvas->height = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        lcd_canvas_panel_t *panel = &canvas->panel[i];
+        *panel = panels[i];
+        esp_err_t ret = lcdSetOrientation(panel->dev, panel->rotation);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "panel %d can not take rotation %d", i, panel->rotation);
+            return ret;
+        }
+        uint16_t right = panel->x + panel->dev->_width;
+        uint16_t bottom = panel->y + panel->dev->_height;
+        if (right > canvas->width) canvas->width = right;
+        if (bottom > canvas->height) canvas->height = bottom;
+    }
+    return ESP_OK;
+}
+
+// Draw pixel
+// x:X coordinate
+// y:Y coordinate
+// color:color
+void lcdCanvasDrawPixel(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t color)
+{
+    for (uint8_t i = 0; i < canvas->panelCount; i++) {
+        lcd_canvas_panel_t *panel = &canvas->panel[i];
+        if (x >= panel->x && x < panel->x + panel->dev->_width && y >= panel->y && y < panel->y + panel->dev->_height) {
+            lcdDrawPixel(panel->dev, x - panel->x, y - panel->y, color);
+        }
+    }
+}
+
+/**
+ * @brief Draw a block of colors, the part on each panel is sent to it. Rows cut by a panel
+ * edge go one by one, whole rows in blocks of at most 65535 colors.
+ *
+ * @param canvas
+ * @param x
+ * @param y
+ * @param width
+ * @param height
+ * @param pixels width * height colors, row by row
+ */
+void lcdCanvasDrawPixels(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *pixels)
+{
+    if (width == 0 || height == 0) return;
+
+    lcd_rect_t local;
+    for (uint8_t i = 0; i < canvas->panelCount; i++) {
+        lcd_canvas_panel_t *panel = &canvas->panel[i];
+        if (!canvas_clip(panel, x, y, x + width - 1, y + height - 1, &local)) continue;
+
+        uint16_t cols = local.x2 - local.x1 + 1;
+        uint16_t rows = local.y2 - local.y1 + 1;
+        uint16_t *first = pixels + (size_t)(panel->y + local.y1 - y) * width + (panel->x + local.x1 - x);
+        if (cols == width) {
+            uint16_t chunk = UINT16_MAX / cols;
+            for (uint16_t row = 0; row < rows; row += chunk) {
+                uint16_t n = rows - row < chunk ? rows - row : chunk;
+                lcdDrawPixels(panel->dev, local.x1, local.y1 + row, cols, n, first + (size_t)row * width, cols * n);
+            }
+            continue;
+        }
+        for (uint16_t row = 0; row < rows; row++) {
+            lcdDrawPixels(panel->dev, local.x1, local.y1 + row, cols, 1, first + (size_t)row * width, cols);
+        }
+    }
+}
+
+/**
+ * @brief Draw a filled rectangle
+ *
+ * @param canvas
+ * @param x
+ * @param y
+ * @param width
+ * @param height
+ * @param color
+ */
+void lcdCanvasDrawFillRect(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color)
+{
+    if (width == 0 || height == 0) return;
+    canvas_fill(canvas, x, y, x + width - 1, y + height - 1, color);
+}
+
+/**
+ * @brief Fill every panel with color
+ *
+ * @param canvas
+ * @param color
+ */
+void lcdCanvasFillScreen(lcd_canvas_t *canvas, uint16_t color)
+{
+    for (uint8_t i = 0; i < canvas->panelCount; i++) {
+        lcdFillScreen(canvas->panel[i].dev, color);
+    }
+}
+
+void lcdCanvasDrawHLine(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t length, uint16_t color)
+{
+    lcdCanvasDrawFillRect(canvas, x, y, length, 1, color);
+}
+
+void lcdCanvasDrawVLine(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t height, uint16_t color)
+{
+    lcdCanvasDrawFillRect(canvas, x, y, 1, height, color);
+}
+
+void lcdCanvasDrawRect(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color)
+{
+    if (width == 0 || height == 0) return;
+    lcdCanvasDrawHLine(canvas, x, y, width, color);
+    lcdCanvasDrawHLine(canvas, x, y + height - 1, width, color);
+    lcdCanvasDrawVLine(canvas, x, y, height, color);
+    lcdCanvasDrawVLine(canvas, x + width - 1, y, height, color);
+}
+
+/**
+ * @brief Draw a line with the pixels lcdDrawLine() sets, each run a single fill per panel
+ *
+ * @param canvas
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ * @param color
+ */
+void lcdCanvasDrawLine(lcd_canvas_t *canvas, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color)
+{
+    lcdLineSpans(x1, y1, x2, y2, color, canvas_fill, canvas);
+}
+
+/**
+ * @brief Draw a circle with the pixels lcdDrawCircle() sets
+ *
+ * @param canvas
+ * @param x0
+ * @param y0
+ * @param r
+ * @param color
+ */
+void lcdCanvasDrawCircle(lcd_canvas_t *canvas, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+{
+    lcdCircleSpans(x0, y0, r, color, canvas_fill, canvas);
+}
+
+/**
+ * @brief Draw a filled circle with the pixels lcdDrawFillCircle() sets, one row fill per step
+ *
+ * @param canvas
+ * @param x0
+ * @param y0
+ * @param r
+ * @param color
+ */
+void lcdCanvasDrawFillCircle(lcd_canvas_t *canvas, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+{
+    lcdFillCircleSpans(x0, y0, r, color, canvas_fill, canvas);
+}
+
+/**
+ * @brief Draw a string in color on bgColor, left to right. Characters may straddle panel edges.
+ * Returns a string length in pixels.
+ *
+ * @param canvas
+ * @param fx
+ * @param x
+ * @param y
+ * @param str
+ * @param color
+ * @param bgColor
+ * @return uint16_t
+ */
+uint16_t lcdCanvasDrawString(lcd_canvas_t *canvas, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor)
+{
+    uint16_t strWidth = 0;
+    for (size_t i = 0; str[i] != 0; i++) {
+        uint8_t pw, ph;
+        if (!GetFontx(fx, str[i], canvas->dots, &pw, &ph)) break;
+        if (x + strWidth + pw > canvas->width || y + ph > canvas->height) break;
+
+        uint16_t rows = LCD_GLYPH_PIXELS / pw;
+        for (uint16_t row = 0; row < ph; row += rows) {
+            if (ph - row < rows) rows = ph - row;
+            lcdExpandGlyph(canvas->dots + row * ((pw + 7) / 8), pw, rows, color, bgColor, false, canvas->glyph, pw);
+            lcdCanvasDrawPixels(canvas, x + strWidth, y + row, pw, rows, canvas->glyph);
+        }
+        strWidth += pw;
+    }
+    return strWidth;
+}
+
+/**
+ * @brief Flush the framebuffers of all panels and wait until they are on the glass. All flushes
+ * are queued before the first wait, so panels on different SPI hosts are sent at the same time.
+ *
+ * @param canvas
+ */
+void lcdCanvasFlush(lcd_canvas_t *canvas)
+{
+    for (uint8_t i = 0; i < canvas->panelCount; i++) {
+        lcdFlushAsync(canvas->panel[i].dev);
+    }
+    lcdCanvasWaitDone(canvas);
+}
+
+/**
+ * @brief Wait until everything queued to the panels is sent
+ *
+ * @param canvas
+ */
+void lcdCanvasWaitDone(lcd_canvas_t *canvas)
+{
+    for (uint8_t i = 0; i < canvas->panelCount; i++) {
+        lcdWaitDone(canvas->panel[i].dev);
+    }
+}
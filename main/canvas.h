@@ -0,0 +1,44 @@
+#ifndef MAIN_CANVAS_H_
+#define MAIN_CANVAS_H_
+#include "st7789.h"
+
+#define LCD_CANVAS_PANELS_MAX	8	// Panels one canvas spans
+
+/**
+ * @brief Where a panel sits on the canvas
+ */
+typedef struct {
+	TFT_t *dev;
+	uint16_t x;       ///< Canvas column of the panel's first pixel
+	uint16_t y;       ///< Canvas row of the panel's first pixel
+	uint8_t rotation; ///< DIRECTION0..DIRECTION270, how the panel is mounted, see lcdSetOrientation()
+} lcd_canvas_panel_t;
+
+/**
+ * @brief One coordinate space over several panels. Drawing calls are clipped to the panels
+ * they touch and go to each of them in panel coordinates.
+ */
+typedef struct {
+	lcd_canvas_panel_t panel[LCD_CANVAS_PANELS_MAX];
+	uint8_t panelCount;
+	uint16_t width;                    ///< Right edge of the rightmost panel
+	uint16_t height;                   ///< Bottom edge of the lowest panel
+	uint8_t dots[LCD_FONT_GLYPH_LEN];  ///< Glyph bitmap read from the font file
+	uint16_t glyph[LCD_GLYPH_PIXELS];  ///< Glyph colors, drawn like lcdDrawPixels()
+} lcd_canvas_t;
+
+esp_err_t lcdCanvasInit(lcd_canvas_t *canvas, const lcd_canvas_panel_t *panels, uint8_t count);
+void lcdCanvasDrawPixel(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t color);
+void lcdCanvasDrawPixels(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *pixels);
+void lcdCanvasDrawFillRect(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color);
+void lcdCanvasFillScreen(lcd_canvas_t *canvas, uint16_t color);
+void lcdCanvasDrawHLine(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t length, uint16_t color);
+void lcdCanvasDrawVLine(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t height, uint16_t color);
+void lcdCanvasDrawRect(lcd_canvas_t *canvas, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t color);
+void lcdCanvasDrawLine(lcd_canvas_t *canvas, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color);
+void lcdCanvasDrawCircle(lcd_canvas_t *canvas, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color);
+void lcdCanvasDrawFillCircle(lcd_canvas_t *canvas, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color);
+uint16_t lcdCanvasDrawString(lcd_canvas_t *canvas, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor);
+void lcdCanvasFlush(lcd_canvas_t *canvas);
+void lcdCanvasWaitDone(lcd_canvas_t *canvas);
+#endif /* MAIN_CANVAS_H_ */
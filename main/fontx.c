@@ -1,5 +1,7 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <stdatomic.h>
 #include <sys/unistd.h>
 #include <sys/stat.h>
 #include "esp_err.h"
@@ -11,12 +13,22 @@
 #define FontxDebug 0 // for Debug
 #define TAG "FONTX"
 
+// Tells a font from the one that was added to the same FontxFile before
+static atomic_uint_least32_t fontxIds;
+
+static uint32_t NewFontxId(void)
+{
+	return atomic_fetch_add(&fontxIds, 1) + 1;
+}
+
 // フォントファイルパスを構造体に保存
 void AddFontx(FontxFile *fx, const char *path)
 {
 	memset(fx, 0, sizeof(FontxFile));
+	fx->id = NewFontxId();
 	fx->path = path;
 	fx->opened = false;
+	fx->cacheBudget = FontxCacheBudget;
 }
 
 // フォント構造体を初期化
@@ -26,6 +38,140 @@ void InitFontx(FontxFile *fxs, const char *f0, const char *f1)
 	AddFontx(&fxs[1], f1);
 }
 
+// Read all glyphs of an ANK font into RAM when the budget allows
+static void LoadFontxTable(FontxFile *fx)
+{
+	size_t len = (size_t)fx->fsz * 256;
+	if(!fx->is_ank || fx->cacheBudget < len) return;
+	uint8_t *table = malloc(len);
+	if(table == NULL) return;
+	if(fseek(fx->file, 17, SEEK_SET) || fread(table, 1, len, fx->file) != len) {
+		// Short font file, its glyphs are read one by one as before
+		free(table);
+		return;
+	}
+	fx->cacheTable = table;
+	for(int i=0;i<FontxCachePages;i++) {
+		fx->cachePage[i] = table + (size_t)i * FontxCachePageGlyphs * fx->fsz;
+	}
+	fx->cacheSize = len;
+}
+
+// Glyph of an ANK font from RAM, loading its page when there is room for it
+static const uint8_t *CachedFontx(FontxFile *fx, uint8_t ascii)
+{
+	int page = ascii / FontxCachePageGlyphs;
+	const uint8_t *glyph = NULL;
+	size_t pageLen = (size_t)FontxCachePageGlyphs * fx->fsz;
+
+	if(fx->cachePage[page]) {
+		fx->hits++;
+	} else if(pageLen <= fx->cacheBudget) {
+		fx->misses++;
+		// Oldest pages go until the new one fits
+		while(fx->cacheSize + pageLen > fx->cacheBudget) {
+			int oldest = -1;
+			for(int i=0;i<FontxCachePages;i++) {
+				if(fx->cachePage[i] && (oldest < 0 || fx->cacheUsed[i] < fx->cacheUsed[oldest])) oldest = i;
+			}
+			free(fx->cachePage[oldest]);
+			fx->cachePage[oldest] = NULL;
+			fx->cacheSize -= pageLen;
+		}
+		uint8_t *data = malloc(pageLen);
+		if(data != NULL) {
+			if(fseek(fx->file, 17 + (long)page * pageLen, SEEK_SET) == 0 && fread(data, 1, pageLen, fx->file) == pageLen) {
+				fx->cachePage[page] = data;
+				fx->cacheSize += pageLen;
+			} else {
+				free(data);
+			}
+		}
+	} else {
+		fx->misses++;
+	}
+	if(fx->cachePage[page]) {
+		fx->cacheUsed[page] = ++fx->cacheTick;
+		glyph = fx->cachePage[page] + (size_t)(ascii % FontxCachePageGlyphs) * fx->fsz;
+	}
+	return glyph;
+}
+
+/**
+ * @brief Use a font built into the firmware. It is open and valid right away, glyphs are
+ * read straight from flash.
+ *
+ * @param fx
+ * @param font NULL leaves fx without a font
+ */
+void AddFontxEmbedded(FontxFile *fx, const FontxEmbedded *font)
+{
+	memset(fx, 0, sizeof(FontxFile));
+	fx->id = NewFontxId();
+	fx->opened = true;
+	if(font == NULL) return;
+	fx->path = font->name;
+	memcpy(fx->fxname, font->fxname, sizeof(fx->fxname));
+	fx->is_ank = font->is_ank;
+	fx->w = font->w;
+	fx->h = font->h;
+	fx->fsz = font->fsz;
+	fx->bc = font->bc;
+	fx->data = font->glyphs;
+	fx->valid = true;
+}
+
+// InitFontx() for embedded fonts
+void InitFontxEmbedded(FontxFile *fxs, const FontxEmbedded *f0, const FontxEmbedded *f1)
+{
+	AddFontxEmbedded(&fxs[0], f0);
+	AddFontxEmbedded(&fxs[1], f1);
+}
+
+/**
+ * @brief Use a FONTX file that is already in memory, e.g. in a memory-mapped asset pack.
+ * Glyphs are read from it in place.
+ *
+ * @param fx
+ * @param name shown in messages
+ * @param data the whole .fnt file
+ * @param size bytes of data
+ * @return false when data is no font that can be drawn
+ */
+bool AddFontxMemory(FontxFile *fx, const char *name, const uint8_t *data, size_t size)
+{
+	memset(fx, 0, sizeof(FontxFile));
+	fx->id = NewFontxId();
+	fx->path = name;
+	fx->opened = true;
+	if(size < 18 || memcmp(data, "FONTX2", 6) != 0) {
+		printf("Fontx:%s not FONTX format.\n",name);
+		return false;
+	}
+	memcpy(fx->fxname, &data[6], 8);
+	fx->w = data[14];
+	fx->h = data[15];
+	fx->is_ank = (data[16] == 0);
+	if(!fx->is_ank) {
+		// Glyphs are looked up as data + code * fsz, there is no code block table
+		printf("Fontx:%s only ANK fonts can be read from memory.\n",name);
+		return false;
+	}
+	fx->bc = data[17];
+	fx->fsz = (fx->w + 7)/8 * fx->h;
+	if(fx->fsz > FontxGlyphBufSize){
+		printf("Fontx:%s is too big font size.\n",name);
+		return false;
+	}
+	if(size < 17 + (size_t)fx->fsz * 256) {
+		printf("Fontx:%s is truncated.\n",name);
+		return false;
+	}
+	fx->data = data + 17;
+	fx->valid = true;
+	return true;
+}
+
 // フォントファイルをOPEN
 bool OpenFontx(FontxFile *fx)
 {
@@ -67,19 +213,66 @@ bool OpenFontx(FontxFile *fx)
 			return fx->valid ;
 		}
 		fx->valid = true;
+		LoadFontxTable(fx);
 	}
 	return fx->valid;
 }
 
+// Drop all cached glyphs
+static void FreeFontxCache(FontxFile *fx)
+{
+	if(fx->cacheTable) {
+		free(fx->cacheTable);
+		fx->cacheTable = NULL;
+		memset(fx->cachePage, 0, sizeof(fx->cachePage));
+	}
+	for(int i=0;i<FontxCachePages;i++) {
+		free(fx->cachePage[i]);
+		fx->cachePage[i] = NULL;
+	}
+	fx->cacheSize = 0;
+}
+
 // フォントファイルをCLOSE
 void CloseFontx(FontxFile *fx)
 {
-	if(fx->opened){
+	FreeFontxCache(fx);
+	if(fx->opened && fx->file){
 		fclose(fx->file);
 		fx->opened = false;
 	}
 }
 
+/**
+ * @brief Bytes of glyphs the font keeps in RAM. A budget that holds all 256 glyphs loads
+ * them with one read when the font opens, a smaller one loads pages of FontxCachePageGlyphs
+ * glyphs on first use and drops the least recently used page when it runs out. Only
+ * single-byte (ANK) fonts are cached, double-byte fonts such as Kanji fonts are read from
+ * the file glyph by glyph. Embedded fonts are read from flash and not cached.
+ *
+ * @param fx
+ * @param budget 0 reads every glyph from the file
+ */
+void SetFontxCache(FontxFile *fx, size_t budget)
+{
+	FreeFontxCache(fx);
+	fx->cacheBudget = budget;
+	if(fx->opened && fx->valid && fx->file) LoadFontxTable(fx);
+}
+
+/**
+ * @brief Glyphs served from RAM and glyphs read from the file since the font was added
+ *
+ * @param fx
+ * @param hits
+ * @param misses
+ */
+void GetFontxCacheStats(FontxFile *fx, uint32_t *hits, uint32_t *misses)
+{
+	if(hits) *hits = fx->hits;
+	if(misses) *misses = fx->misses;
+}
+
 // フォント構造体の表示
 void DumpFontx(FontxFile *fxs)
 {
@@ -213,6 +406,13 @@ bool GetFontx(FontxFile *fxs, uint8_t ascii, uint8_t *pGlyph, uint8_t *pw, uint8
 		//if(ascii < 0xFF){
 			if(fxs[i].is_ank){
 				if(FontxDebug)printf("[GetFontx]fxs.is_ank fxs.fsz=%d\n",fxs[i].fsz);
+				const uint8_t *glyph = fxs[i].data ? fxs[i].data + ascii * fxs[i].fsz : CachedFontx(&fxs[i], ascii);
+				if(glyph) {
+					memcpy(pGlyph, glyph, fxs[i].fsz);
+					if(pw) *pw = fxs[i].w;
+					if(ph) *ph = fxs[i].h;
+					return true;
+				}
 				offset = 17 + ascii * fxs[i].fsz;
 				if(FontxDebug)printf("[GetFontx]offset=%u\n",offset);
 				if(fseek(fxs[i].file, offset, SEEK_SET)) {
@@ -1,6 +1,24 @@
 #ifndef MAIN_FONTX_H_
 #define MAIN_FONTX_H_
 #define FontxGlyphBufSize (32*32/8)
+#define FontxCacheBudget (16*1024)	// Default bytes of glyphs a font keeps in RAM, see SetFontxCache()
+#define FontxCachePageGlyphs 16	// Glyphs read and evicted together
+#define FontxCachePages (256/FontxCachePageGlyphs)
+
+/**
+ * @brief Font converted to a const array at build time by tools/fnt2c.py, the FontxFile
+ * fields it needs are worked out already
+ */
+typedef struct {
+	const char *name;        // File it was made from
+	char  fxname[10];
+	bool  is_ank;
+	uint8_t w;
+	uint8_t h;
+	uint16_t fsz;
+	uint8_t bc;
+	const uint8_t *glyphs;   // 256 glyphs of fsz bytes
+} FontxEmbedded;
 
 typedef struct {
 	const char *path;
@@ -13,13 +31,28 @@ typedef struct {
 	uint16_t fsz;
 	uint8_t bc;
 	FILE *file;
+	const uint8_t *data;                  // Glyphs in flash or RAM, NULL for a font file
+	size_t cacheBudget;                   // Bytes of glyphs kept in RAM, 0 reads each glyph from the file
+	size_t cacheSize;                     // Bytes of glyphs in RAM now
+	uint8_t *cacheTable;                  // All 256 glyphs when they fit in the budget
+	uint8_t *cachePage[FontxCachePages];  // Loaded pages, NULL when on file only
+	uint32_t cacheUsed[FontxCachePages];  // Last use of each page, the oldest is evicted
+	uint32_t cacheTick;
+	uint32_t hits;                        // Glyphs found in RAM
+	uint32_t misses;                      // Glyphs read from the file
+	uint32_t id;                          // New for every font added, never 0
 } FontxFile;
 
 void AaddFontx(FontxFile *fx, const char *path);
 void InitFontx(FontxFile *fxs, const char *f0, const char *f1);
+void AddFontxEmbedded(FontxFile *fx, const FontxEmbedded *font);
+void InitFontxEmbedded(FontxFile *fxs, const FontxEmbedded *f0, const FontxEmbedded *f1);
+bool AddFontxMemory(FontxFile *fx, const char *name, const uint8_t *data, size_t size);
 bool OpenFontx(FontxFile *fx);
 void CloseFontx(FontxFile *fx);
 void DumpFontx(FontxFile *fxs);
+void SetFontxCache(FontxFile *fx, size_t budget);
+void GetFontxCacheStats(FontxFile *fx, uint32_t *hits, uint32_t *misses);
 uint8_t getFortWidth(FontxFile *fx);
 uint8_t getFortHeight(FontxFile *fx);
 bool GetFontx(FontxFile *fxs, uint8_t ascii , uint8_t *pGlyph, uint8_t *pw, uint8_t *ph);
@@ -0,0 +1,163 @@
+#include <stdint.h>
+
+#include "geometry.h"
+
+// sin(0..90 degrees) in Q16
+static const q16_t sine[91] = {
+    0, 1144, 2287, 3430, 4572, 5712, 6850, 7987,
+    9121, 10252, 11380, 12505, 13626, 14742, 15855, 16962,
+    18064, 19161, 20252, 21336, 22415, 23486, 24550, 25607,
+    26656, 27697, 28729, 29753, 30767, 31772, 32768, 33754,
+    34729, 35693, 36647, 37590, 38521, 39441, 40348, 41243,
+    42126, 42995, 43852, 44695, 45525, 46341, 47143, 47930,
+    48703, 49461, 50203, 50931, 51643, 52339, 53020, 53684,
+    54332, 54963, 55578, 56175, 56756, 57319, 57865, 58393,
+    58903, 59396, 59870, 60326, 60764, 61183, 61584, 61966,
+    62328, 62672, 62997, 63303, 63589, 63856, 64104, 64332,
+    64540, 64729, 64898, 65048, 65177, 65287, 65376, 65446,
+    65496, 65526, 65536,
+};
+
+/**
+ * @brief Sine of a whole number of degrees
+ *
+ * @param angle degrees, any value
+ * @return q16_t
+ */
+q16_t geoSin(int32_t angle)
+{
+    angle %= 360;
+    if (angle < 0) angle += 360;
+    if (angle <= 90) return sine[angle];
+    if (angle <= 180) return sine[180 - angle];
+    if (angle <= 270) return -sine[angle - 180];
+    return -sine[360 - angle];
+}
+
+/**
+ * @brief Cosine of a whole number of degrees
+ *
+ * @param angle degrees, any value
+ * @return q16_t
+ */
+q16_t geoCos(int32_t angle)
+{
+    return geoSin(angle % 360 + 90);
+}
+
+/**
+ * @brief Integer part of a Q16 value, rounded toward zero like a cast from double
+ *
+ * @param v
+ * @return int32_t
+ */
+int32_t geoTrunc(int64_t v)
+{
+    return v >= 0 ? (int32_t)(v >> 16) : -(int32_t)((-v) >> 16);
+}
+
+/**
+ * @brief Integer square root, rounded down. Bit by bit, without multiplications.
+ *
+ * @param v
+ * @return uint32_t
+ */
+uint32_t geoSqrt(uint64_t v)
+{
+    if (v == 0) return 0;
+    uint64_t root = 0;
+    // Highest even power of two not above v
+    uint64_t bit = (uint64_t)1 << ((63 - __builtin_clzll(v)) & ~1);
+    while (bit != 0) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * @brief Turn point x,y around the origin by angle degrees counterclockwise on the panel,
+ * then move it by xc,yc. The result is cut to whole pixels toward zero, as the shapes of
+ * st7789.c always did.
+ *
+ * @param x
+ * @param y
+ * @param angle degrees
+ * @param xc
+ * @param yc
+ * @param rx
+ * @param ry
+ */
+void geoRotate(int32_t x, int32_t y, int32_t angle, int32_t xc, int32_t yc, int32_t *rx, int32_t *ry)
+{
+    int64_t s = geoSin(angle);
+    int64_t c = geoCos(angle);
+    *rx = geoTrunc(x * c + y * s + (int64_t)xc * Q16_ONE);
+    *ry = geoTrunc(y * c - x * s + (int64_t)yc * Q16_ONE);
+}
+
+/**
+ * @brief Nearest whole number of a Q16 value, halves rounded up
+ *
+ * @param v
+ * @return int32_t
+ */
+int32_t geoRound(int64_t v)
+{
+    v += Q16_ONE / 2;
+    return v >= 0 ? (int32_t)(v / Q16_ONE) : -(int32_t)((-v + Q16_ONE - 1) / Q16_ONE);
+}
+
+/**
+ * @brief Vector of length w square to dx,dy, turned from it toward -x on the panel
+ *
+ * @param dx
+ * @param dy
+ * @param w length in Q16
+ * @param nx Q16, 0 when dx,dy is a point
+ * @param ny Q16, 0 when dx,dy is a point
+ */
+void geoNormal(int32_t dx, int32_t dy, int64_t w, q16_t *nx, q16_t *ny)
+{
+    int64_t vx = dx;
+    int64_t vy = dy;
+    // Length in Q14, squares of 16-bit coordinates leave room for 28 bits of fraction
+    uint32_t length = geoSqrt((uint64_t)(vx * vx + vy * vy) << 28);
+    if (length == 0) {
+        *nx = *ny = 0;
+        return;
+    }
+    // w over the length in Q26, one division for both parts, then rounded to Q16
+    int64_t scale = ((w << 24) + length / 2) / length;
+    int64_t ox = vy * scale;
+    int64_t oy = vx * scale;
+    *nx = -(q16_t)((ox + (ox < 0 ? -512 : 512)) / 1024);
+    *ny = (q16_t)((oy + (oy < 0 ? -512 : 512)) / 1024);
+}
+
+/**
+ * @brief Corners of an arrow base: the points w to the left and right of x0,y0, square to
+ * the shaft from x0,y0 to the tip x1,y1
+ *
+ * @param x0
+ * @param y0
+ * @param x1
+ * @param y1
+ * @param w
+ * @param left x and y of the left corner
+ * @param right x and y of the right corner
+ */
+void geoArrowBase(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t w, int32_t *left, int32_t *right)
+{
+    q16_t nx, ny;
+    geoNormal(x1 - x0, y1 - y0, (int64_t)w * Q16_ONE, &nx, &ny);
+    left[0] = geoTrunc((int64_t)x0 * Q16_ONE + nx);
+    left[1] = geoTrunc((int64_t)y0 * Q16_ONE + ny);
+    right[0] = geoTrunc((int64_t)x0 * Q16_ONE - nx);
+    right[1] = geoTrunc((int64_t)y0 * Q16_ONE - ny);
+}
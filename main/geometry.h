@@ -0,0 +1,18 @@
+#ifndef MAIN_GEOMETRY_H_
+#define MAIN_GEOMETRY_H_
+#include <stdint.h>
+
+// Signed 16.16 fixed point
+typedef int32_t q16_t;
+
+#define Q16_ONE		(1 << 16)
+
+q16_t geoSin(int32_t angle);
+q16_t geoCos(int32_t angle);
+int32_t geoTrunc(int64_t v);
+int32_t geoRound(int64_t v);
+uint32_t geoSqrt(uint64_t v);
+void geoRotate(int32_t x, int32_t y, int32_t angle, int32_t xc, int32_t yc, int32_t *rx, int32_t *ry);
+void geoNormal(int32_t dx, int32_t dy, int64_t w, q16_t *nx, q16_t *ny);
+void geoArrowBase(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t w, int32_t *left, int32_t *right);
+#endif /* MAIN_GEOMETRY_H_ */
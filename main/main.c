@@ -7,14 +7,14 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_system.h"
-#include "esp_vfs.h"
-#include "esp_spiffs.h"
 #include "driver/spi_master.h"
 #include "math.h"
 
 #include "st7789.h"
 #include "colors.h"
 #include "fontx.h"
+#include "fonts_embedded.h"
+#include "assets.h"
 
 #define	INTERVAL 2000/portTICK_PERIOD_MS
 #define WAIT vTaskDelay(INTERVAL)
@@ -33,18 +33,6 @@ static const char *TAG = "ST7789";
 
 static FontxFile fontFile[2];
 
-static void SPIFFS_Directory(char * path)
-{
-    DIR* dir = opendir(path);
-    assert(dir != NULL);
-    while (true) {
-        struct dirent*pe = readdir(dir);
-        if (!pe) break;
-        ESP_LOGI(__FUNCTION__,"d_name=%s d_ino=%d d_type=%x", pe->d_name,pe->d_ino, pe->d_type);
-    }
-    closedir(dir);
-}
-
 double getTimeSec( void )
 {
     struct timespec spec;
@@ -68,10 +56,8 @@ void TimerTextTest(TFT_t *dev)
     while (getTimeSec() - startTime <= displayPeriod) {
         sprintf(str, "Elapsed %.2fs", getTimeSec());
 
-        uint16_t strWidth = lcdDrawString(dev, fontFile, xpos, ypos, str, textColor, bgColor);
-        uint16_t strEnd = xpos + strWidth;
-        // Filling a background after the string to the display edge
-        lcdDrawFillRect(dev, strEnd, ypos, dev->_width - strEnd, ypos + 24, bgColor);
+        // Background after the string up to the display edge goes out in the same window
+        lcdDrawStringPadded(dev, fontFile, xpos, ypos, str, textColor, bgColor, dev->_width - xpos);
     }
 
     ESP_LOGI(__FUNCTION__, "Completed.");
@@ -324,42 +310,6 @@ void ST7789_Tests(void *pvParameters)
     }
 }
 
-void InitSpiffs() {
-    ESP_LOGI(TAG, "Initializing SPIFFS");
-
-    esp_vfs_spiffs_conf_t conf = {
-        .base_path = "/spiffs",
-        .partition_label = NULL,
-        .max_files = 10,
-        .format_if_mount_failed =true
-    };
-
-    // Use settings defined above toinitialize and mount SPIFFS filesystem.
-    // Note: esp_vfs_spiffs_register is anall-in-one convenience function.
-    esp_err_t ret = esp_vfs_spiffs_register(&conf);
-
-    if (ret != ESP_OK) {
-        if (ret == ESP_FAIL) {
-            ESP_LOGE(TAG, "Failed to mount or format filesystem");
-        } else if (ret == ESP_ERR_NOT_FOUND) {
-            ESP_LOGE(TAG, "Failed to find SPIFFS partition");
-        } else {
-            ESP_LOGE(TAG, "Failed to initialize SPIFFS (%s)",esp_err_to_name(ret));
-        }
-        return;
-    }
-
-    size_t total = 0, used = 0;
-    ret = esp_spiffs_info(NULL, &total,&used);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG,"Failed to get SPIFFS partition information (%s)",esp_err_to_name(ret));
-    } else {
-        ESP_LOGI(TAG,"Partition size: total: %d, used: %d", total, used);
-    }
-
-    SPIFFS_Directory("/spiffs/");
-}
-
 void InitDisplay(TFT_t *display)
 {
     ESP_LOGI(TAG, "Initializing display");
@@ -397,10 +347,16 @@ void app_main(void)
 {
     static TFT_t display;
 
-    InitSpiffs();
     InitDisplay(&display);
 
-    InitFontx(fontFile,"/spiffs/font10x20-KOI8-R.fnt","");
+    // Read in place from the asset pack that 'idf.py flash' writes. 'idf.py app-flash' leaves
+    // the partition empty, the copy built into the firmware stands in then.
+    static lcd_assets_t assets;
+    if (lcdAssetsOpen(&assets, "assets") != ESP_OK ||
+        lcdAssetsInitFont(&assets, fontFile, "font10x20-KOI8-R.fnt", NULL) != ESP_OK) {
+        ESP_LOGW(TAG, "No asset pack, using the embedded font");
+        InitFontxEmbedded(fontFile, &fontx_font10x20_KOI8_R, NULL);
+    }
 
     ESP_LOGI(TAG, "Init complete");
 
@@ -1,5 +1,6 @@
 #include <string.h>
-#include <math.h>
+#include <stdlib.h>
+#include <stdatomic.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -7,9 +8,12 @@
 #include <driver/spi_master.h>
 #include <hal/spi_types.h>
 #include <driver/gpio.h>
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "st7789.h"
+#include "geometry.h"
 #include "st7789_commands.h"
 
 #define TAG "ST7789"
@@ -17,14 +21,74 @@
 #define SPI_CMD_MODE  0x00
 #define SPI_DATA_MODE 0x01
 
-#define MAX_WRITE_BUFF_COLORS 512
-#define WRITE_BUFF_LEN MAX_WRITE_BUFF_COLORS*2
-#define FONT_GLYPH_BUFF_LEN 256
-#define DISPLAY_GLYPH_BUFF_LEN 512
+#define DEFAULT_BUFF_LEN 4096            // Bytes in each DMA buffer
+#define DEFAULT_BUFF_COUNT 2            // Ping-pong: one buffer is filled while the other is on the wire
+#define DEFAULT_FILL_CACHE_SIZE 2       // Fill patterns kept, typically the background and one theme color
+#define DEFAULT_MAX_TRANSFER_SZ (32 * 1024) // Largest single transaction, zero-copy writes are split by it
+#define MIN_CHUNK_LEN 256               // Lower bound of an adaptive chunk
+#define CHUNK_OVERHEAD_RATIO 19         // Adaptive chunks keep the per-transaction overhead at about 5% of wire time
+#define CALIBRATION_TRANS 16            // Transactions timed to measure the overhead
+#define SCAN_LINES 344                  // Lines of one refresh: 320 gate lines and the default 12 + 12 porch lines
+#define DEFAULT_FRAME_US 16667          // Refresh period until one is measured, the 60 Hz FRCTRL2 default
+#define SYNC_SPIN_US 2000               // Waits for the scanline shorter than this spin instead of sleeping
+#define GRAM_LINES 320                  // Rows of panel memory, the VSCRDEF areas add up to this
+#define GRAM_COLUMNS 240                // Columns of panel memory
+#define FB_MERGE_SLACK 256              // Unchanged pixels worth resending to save the window setup of a separate dirty rectangle
+#define SERVICE_STACK 4096              // Stack of the service task, the font code reads glyphs on it
+#define SERVICE_INLINE 64               // Bytes of colors or text a queue entry carries, larger calls wait until they ran
 
-static uint8_t* write_buff;                    // Write colors buffer
-static uint8_t  dots[FONT_GLYPH_BUFF_LEN];	   // Font file glyph buffet
-static uint16_t glyph[DISPLAY_GLYPH_BUFF_LEN]; // Glyph buffer for display write
+/**
+ * @brief Screen rows that map to consecutive panel memory rows
+ */
+typedef struct {
+    uint16_t y;    ///< First screen row
+    uint16_t row;  ///< Panel memory row it is drawn to
+    uint16_t rows;
+} lcd_span_t;
+
+typedef bool (*lcd_capture_t)(void *dev, const lcd_cmd_t *cmd);
+
+/**
+ * @brief Panels on an SPI host: the first one initializes the bus, the last one frees it
+ */
+typedef struct {
+    uint8_t users;
+    bool owned;           ///< Initialized here, not by the application
+    bool unselected;      ///< A panel without CS is on the bus, it takes the traffic of the others too
+    uint32_t maxTransfer; ///< max_transfer_sz of the bus
+} lcd_bus_t;
+
+static lcd_bus_t buses[SPI_HOST_MAX];
+
+/**
+ * @brief Queue entry of the service task
+ */
+typedef struct {
+    atomic_uint seq;  ///< Queue position the entry is free for, that position + 1 once it is filled
+    lcd_cmd_t cmd;
+    uint32_t data[SERVICE_INLINE / 4]; ///< Copy of the colors or text of cmd
+} lcd_service_slot_t;
+
+/**
+ * @brief Render task with a bounded multi-producer queue. Producers claim positions with a
+ * compare-and-swap on head, the single consumer frees entries by advancing their seq.
+ */
+struct lcd_service {
+    lcd_service_slot_t *slots;
+    uint32_t mask;              ///< Entries - 1, a power of two
+    atomic_uint head;           ///< Next position producers claim
+    atomic_uint tail;           ///< Next position the task runs, only the task advances it
+    TaskHandle_t task;
+    SemaphoreHandle_t space;    ///< Given when an entry is freed while producers wait for room
+    atomic_uint waiting;        ///< Producers waiting for room
+    atomic_bool sleeping;       ///< The task found the queue empty and waits for a notification
+    lcd_capture_t capture;      ///< Capture hook of calls the task runs itself (band frames)
+    uint32_t maxDepth;
+    atomic_uint stalls;
+    atomic_uint inlineMiss;
+    uint32_t baseHead;          ///< head and tail at the last lcdResetServiceStats()
+    uint32_t baseTail;
+};
 
 void delayMS(int ms) 
 {
@@ -33,12 +97,23 @@ void delayMS(int ms)
     vTaskDelay(xTicksToDelay);
 }
 
+/**
+ * @brief Sets the D/C line right before a transaction is clocked out, so commands
+ * and data can be queued back to back.
+ *
+ * @param trans transaction with a lcd_dc_t in the user field
+ */
+static void IRAM_ATTR spi_master_pre_transfer_callback(spi_transaction_t *trans)
+{
+    lcd_dc_t *dc = (lcd_dc_t *)trans->user;
+    gpio_set_level(dc->pin, dc->level);
+}
+
 void spi_master_init(TFT_t *dev, display_config_t *display_config, spi_device_interface_config_t *spiInterfaceConfig)
 {
-    if (display_config->pinCS >= 0) {
-        gpio_reset_pin( display_config->pinCS );
-        gpio_set_direction( display_config->pinCS, GPIO_MODE_OUTPUT );
-        gpio_set_level( display_config->pinCS, 0 );
+    // The driver selects the panel for each transaction, so other panels can share the bus
+    if (display_config->pinCS >= 0 && spiInterfaceConfig->spics_io_num < 0) {
+        spiInterfaceConfig->spics_io_num = display_config->pinCS;
     }
 
     gpio_reset_pin(display_config->pinDC);
@@ -62,19 +137,59 @@ void spi_master_init(TFT_t *dev, display_config_t *display_config, spi_device_in
         gpio_set_level(display_config->pinBL, 0);
     }
 
+    // Sizes stay multiples of 4 bytes, so every split of a DMA buffer keeps its word alignment
+    lcd_bus_t *bus = &buses[display_config->spiHost];
+    uint32_t maxTransfer = display_config->maxTransferSize > 0 ? display_config->maxTransferSize : DEFAULT_MAX_TRANSFER_SZ;
+    if (bus->users > 0 && bus->owned) {
+        // Set by the first panel on the bus
+        maxTransfer = bus->maxTransfer;
+    }
+    maxTransfer &= ~3;
+    uint32_t buffLen = display_config->bufferSize > 0 ? display_config->bufferSize : DEFAULT_BUFF_LEN;
+    buffLen &= ~3;
+    if (buffLen > maxTransfer) {
+        buffLen = maxTransfer;
+    }
+    uint8_t buffCount = display_config->bufferCount > 0 ? display_config->bufferCount : DEFAULT_BUFF_COUNT;
+    if (buffCount > LCD_DMA_BUFF_MAX) {
+        buffCount = LCD_DMA_BUFF_MAX;
+    }
+
     spi_bus_config_t buscfg = {
         .mosi_io_num = display_config->pinMOSI,
         .miso_io_num = -1,
         .sclk_io_num = display_config->pinSCLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = 0,
+        .max_transfer_sz = maxTransfer,
         .flags = 0
     };
 
-    esp_err_t ret = spi_bus_initialize(display_config->spiHost, &buscfg, SPI_DMA_CH_AUTO);
-    ESP_LOGD(TAG, "spi_bus_initialize=%d",ret);
-    assert(ret==ESP_OK);
+    esp_err_t ret;
+    if (bus->users == 0) {
+        ret = spi_bus_initialize(display_config->spiHost, &buscfg, SPI_DMA_CH_AUTO);
+        ESP_LOGD(TAG, "spi_bus_initialize=%d",ret);
+        // ESP_ERR_INVALID_STATE: the application set up the bus, e.g. for an SD card on it
+        assert(ret==ESP_OK || ret==ESP_ERR_INVALID_STATE);
+        bus->owned = ret == ESP_OK;
+        bus->maxTransfer = maxTransfer;
+    }
+    bool selected = spiInterfaceConfig->spics_io_num >= 0;
+    if (bus->users > 0 && (!selected || bus->unselected)) {
+        ESP_LOGW(TAG, "panels sharing SPI host %d need CS pins", display_config->spiHost);
+    }
+    bus->unselected |= !selected;
+    bus->users++;
+
+    // D/C is driven per transaction from the callback
+    spiInterfaceConfig->pre_cb = spi_master_pre_transfer_callback;
+    if (display_config->frameSync == LCD_SYNC_SCANLINE) {
+        // No MISO wire: the panel answers GDCAN on the data line, after the command in the same transaction
+        spiInterfaceConfig->flags |= SPI_DEVICE_3WIRE | SPI_DEVICE_HALFDUPLEX;
+    }
+    if (spiInterfaceConfig->queue_size < LCD_TRANS_QUEUE_LEN) {
+        spiInterfaceConfig->queue_size = LCD_TRANS_QUEUE_LEN;
+    }
 
     spi_device_handle_t handle;
     ret = spi_bus_add_device(display_config->spiHost, spiInterfaceConfig, &handle);
@@ -84,88 +199,465 @@ void spi_master_init(TFT_t *dev, display_config_t *display_config, spi_device_in
     dev->_dc = display_config->pinDC;
     dev->_bl = display_config->pinBL;
     dev->_SPIHandle = handle;
+    dev->_host = display_config->spiHost;
+
+    dev->_dc_mode[SPI_CMD_MODE].pin = display_config->pinDC;
+    dev->_dc_mode[SPI_CMD_MODE].level = SPI_CMD_MODE;
+    dev->_dc_mode[SPI_DATA_MODE].pin = display_config->pinDC;
+    dev->_dc_mode[SPI_DATA_MODE].level = SPI_DATA_MODE;
+    dev->_trans_queued = 0;
+    dev->_trans_done = 0;
+    memset(dev->_trans_cb, 0, sizeof(dev->_trans_cb));
+    dev->_win_valid = false;
+    memset(&dev->_win_stats, 0, sizeof(lcd_window_stats_t));
+
+    dev->_clock_hz = spiInterfaceConfig->clock_speed_hz;
+    dev->_max_transfer = maxTransfer;
+    dev->diplayBufferLen = buffLen;
+    dev->_chunk_len = buffLen;
 
     // DMA buffer allocation
-    write_buff = heap_caps_malloc(WRITE_BUFF_LEN, MALLOC_CAP_DMA);
+    for (uint8_t i = 0; i < buffCount; i++) {
+        dev->_dma_buff[i] = heap_caps_malloc(buffLen, MALLOC_CAP_DMA);
+        assert(dev->_dma_buff[i] != NULL);
+        dev->_dma_seq[i] = 0;
+    }
+    dev->_dma_count = buffCount;
+    dev->_dma_head = 0;
+
+    uint8_t fillCount = display_config->fillCacheSize > 0 ? display_config->fillCacheSize : DEFAULT_FILL_CACHE_SIZE;
+    if (fillCount > LCD_FILL_CACHE_MAX) {
+        fillCount = LCD_FILL_CACHE_MAX;
+    }
+    for (uint8_t i = 0; i < fillCount; i++) {
+        dev->_fill[i].buff = heap_caps_malloc(buffLen, MALLOC_CAP_DMA);
+        assert(dev->_fill[i].buff != NULL);
+        dev->_fill[i].len = 0;
+        dev->_fill[i].seq = 0;
+        dev->_fill[i].lastUse = 0;
+    }
+    dev->_fill_count = fillCount;
+    dev->_fill_clock = 0;
+
+    uint8_t glyphCount = display_config->glyphCacheSize;
+    if (glyphCount > LCD_GLYPH_CACHE_MAX) {
+        glyphCount = LCD_GLYPH_CACHE_MAX;
+    }
+    memset(dev->_glyph_cache, 0, sizeof(dev->_glyph_cache));
+    for (uint8_t i = 0; i < glyphCount; i++) {
+        dev->_glyph_cache[i].pixels = heap_caps_malloc(LCD_GLYPH_PIXELS * 2, MALLOC_CAP_DMA);
+        assert(dev->_glyph_cache[i].pixels != NULL);
+    }
+    dev->_glyph_count = glyphCount;
+    dev->_glyph_clock = 0;
+    memset(&dev->_glyph_stats, 0, sizeof(lcd_glyph_stats_t));
+
+    // Allocated by the first lcdDrawString()
+    dev->_strip = NULL;
+    dev->_strip_len = 0;
+    dev->_strip_seq = 0;
+    dev->_strip_busy = false;
 }
 
-bool spi_master_write_bytes(spi_device_handle_t SPIHandle, uint8_t *bytes, size_t len)
+/**
+ * @brief Account a finished transaction and run its completion callback
+ *
+ * @param dev
+ * @param trans
+ */
+static void spi_master_complete(TFT_t *dev, spi_transaction_t *trans)
 {
-    spi_transaction_t SPITransaction;
-    esp_err_t ret;
+    dev->_trans_done++;
+
+    uint8_t slot = trans - dev->_trans;
+    lcd_done_cb_t doneCb = dev->_trans_cb[slot];
+    if (doneCb != NULL) {
+        dev->_trans_cb[slot] = NULL;
+        doneCb(dev->_trans_cb_arg[slot]);
+    }
+}
+
+/**
+ * @brief Wait for the oldest queued transaction to complete
+ *
+ * @param dev
+ */
+static void spi_master_reap(TFT_t *dev)
+{
+    spi_transaction_t *trans;
+    esp_err_t ret = spi_device_get_trans_result(dev->_SPIHandle, &trans, portMAX_DELAY);
+    assert(ret==ESP_OK);
+    spi_master_complete(dev, trans);
+}
+
+/**
+ * @brief Wait until all queued transactions are sent
+ *
+ * @param dev
+ */
+void spi_master_wait(TFT_t *dev)
+{
+    while (dev->_trans_done != dev->_trans_queued) {
+        spi_master_reap(dev);
+    }
+}
+
+/**
+ * @brief Take the next free transaction of the ring, cleared and bound to a D/C level
+ *
+ * @param dev
+ * @param mode SPI_CMD_MODE or SPI_DATA_MODE
+ * @return spi_transaction_t*
+ */
+static spi_transaction_t *spi_master_next_trans(TFT_t *dev, uint8_t mode)
+{
+    // Transactions complete in order, so the slot is free once the one queued a ring length ago is done
+    while (dev->_trans_queued - dev->_trans_done >= LCD_TRANS_QUEUE_LEN) {
+        spi_master_reap(dev);
+    }
 
-    memcpy(write_buff, bytes, len);
-    memset(&SPITransaction, 0, sizeof(spi_transaction_t));
+    spi_transaction_t *trans = &dev->_trans[dev->_trans_queued % LCD_TRANS_QUEUE_LEN];
+    memset(trans, 0, sizeof(spi_transaction_t));
+    trans->user = &dev->_dc_mode[mode];
+    return trans;
+}
 
-    SPITransaction.length = len * 8;
-    SPITransaction.tx_buffer = write_buff;
-    ret = spi_device_transmit(SPIHandle, &SPITransaction);
-    
+/**
+ * @brief Queue a transaction taken by spi_master_next_trans() and return without waiting for it
+ *
+ * @param dev
+ * @param trans
+ */
+static void spi_master_queue_trans(TFT_t *dev, spi_transaction_t *trans)
+{
+    esp_err_t ret = spi_device_queue_trans(dev->_SPIHandle, trans, portMAX_DELAY);
     assert(ret==ESP_OK);
+    dev->_trans_queued++;
+}
+
+/**
+ * @brief Reap transactions that are already sent, without blocking
+ *
+ * @param dev
+ */
+static void spi_master_poll(TFT_t *dev)
+{
+    spi_transaction_t *trans;
+    while (dev->_trans_done != dev->_trans_queued) {
+        if (spi_device_get_trans_result(dev->_SPIHandle, &trans, 0) != ESP_OK) {
+            break;
+        }
+        spi_master_complete(dev, trans);
+    }
+}
+
+/**
+ * @brief Wait until the transaction count reaches seq, i.e. a buffer sent up to then is free
+ *
+ * @param dev
+ * @param seq _trans_queued value right after the last transaction using the buffer was queued
+ */
+static void spi_master_wait_seq(TFT_t *dev, uint32_t seq)
+{
+    while ((int32_t)(dev->_trans_done - seq) < 0) {
+        spi_master_reap(dev);
+    }
+}
+
+/**
+ * @brief Take the next buffer of the DMA ring. Blocks only while the buffer is still on the wire.
+ *
+ * @param dev
+ * @return uint8_t* buffer of diplayBufferLen bytes
+ */
+static uint8_t *spi_master_next_buff(TFT_t *dev)
+{
+    uint8_t index = dev->_dma_head;
+    dev->_dma_head = (index + 1) % dev->_dma_count;
+
+    spi_master_wait_seq(dev, dev->_dma_seq[index]);
+    return dev->_dma_buff[index];
+}
+
+/**
+ * @brief Queue data straight from a caller buffer, no copy is made
+ *
+ * @param dev
+ * @param data must stay untouched until the transaction is reaped
+ * @param len bytes to send, up to _max_transfer
+ */
+static void spi_master_queue_data(TFT_t *dev, const void *data, size_t len)
+{
+    spi_transaction_t *trans = spi_master_next_trans(dev, SPI_DATA_MODE);
+    trans->length = len * 8; // bits in a packet
+    trans->tx_buffer = data;
+    spi_master_queue_trans(dev, trans);
+}
+
+/**
+ * @brief Queue a caller buffer of any length without copying, split by _max_transfer
+ *
+ * @param dev
+ * @param data must stay untouched until the transactions are reaped
+ * @param len bytes to send
+ */
+static void spi_master_queue_long(TFT_t *dev, const uint8_t *data, size_t len)
+{
+    for (size_t p = 0; p < len; p += dev->_max_transfer) {
+        size_t chunk = (len - p) > dev->_max_transfer ? dev->_max_transfer : (len - p);
+        spi_master_queue_data(dev, data + p, chunk);
+    }
+}
+
+/**
+ * @brief Queue data from a buffer of the DMA ring
+ *
+ * @param dev
+ * @param buff buffer from spi_master_next_buff()
+ * @param len bytes to send
+ */
+static void spi_master_queue_buff(TFT_t *dev, uint8_t *buff, size_t len)
+{
+    // The buffer is reusable when this transaction is reaped
+    uint8_t index = (dev->_dma_head + dev->_dma_count - 1) % dev->_dma_count;
+    dev->_dma_seq[index] = dev->_trans_queued + 1;
+
+    spi_master_queue_data(dev, buff, len);
+}
+
+/**
+ * @brief Queue bytes with a D/C level. Up to 4 bytes travel inside the transaction itself,
+ * longer payloads are copied to the DMA ring.
+ *
+ * @param dev
+ * @param mode SPI_CMD_MODE or SPI_DATA_MODE
+ * @param bytes
+ * @param len
+ * @return true
+ */
+bool spi_master_write_bytes(TFT_t *dev, uint8_t mode, const uint8_t *bytes, size_t len)
+{
+    if (len <= 4) {
+        spi_transaction_t *trans = spi_master_next_trans(dev, mode);
+        trans->flags = SPI_TRANS_USE_TXDATA;
+        trans->length = len * 8;
+        memcpy(trans->tx_data, bytes, len);
+        spi_master_queue_trans(dev, trans);
+        return true;
+    }
+
+    assert(mode == SPI_DATA_MODE);
+    for (size_t p = 0; p < len; p += dev->_chunk_len) {
+        size_t chunk = (len - p) > dev->_chunk_len ? dev->_chunk_len : (len - p);
+        uint8_t *buff = spi_master_next_buff(dev);
+        memcpy(buff, bytes + p, chunk);
+        spi_master_queue_buff(dev, buff, chunk);
+    }
     return true;
 }
 
 bool spi_master_write_command(TFT_t * dev, uint8_t cmd)
 {
-    gpio_set_level(dev->_dc, SPI_CMD_MODE);
-    return spi_master_write_bytes(dev->_SPIHandle, &cmd, 1);
+    // The command may move the panel write pointer or change addressing
+    dev->_win_valid = false;
+    return spi_master_write_bytes(dev, SPI_CMD_MODE, &cmd, 1);
 }
 
 bool spi_master_write_data_byte(TFT_t * dev, uint8_t data)
 {
-    gpio_set_level(dev->_dc, SPI_DATA_MODE);
-    return spi_master_write_bytes(dev->_SPIHandle, &data, 1);
+    return spi_master_write_bytes(dev, SPI_DATA_MODE, &data, 1);
 }
 
 bool spi_master_write_data_word(TFT_t * dev, uint16_t data)
 {
-    static uint8_t bytes[2];
+    uint8_t bytes[2];
     bytes[0] = (data >> 8) & 0xFF;
     bytes[1] = data & 0xFF;
-    gpio_set_level( dev->_dc, SPI_DATA_MODE );
-    return spi_master_write_bytes(dev->_SPIHandle, bytes, 2);
+    return spi_master_write_bytes(dev, SPI_DATA_MODE, bytes, 2);
 }
 
 bool spi_master_write_addr(TFT_t * dev, uint16_t addr1, uint16_t addr2)
 {
-    static uint8_t bytes[4];
+    uint8_t bytes[4];
     bytes[0] = (addr1 >> 8) & 0xFF;
     bytes[1] = addr1 & 0xFF;
     bytes[2] = (addr2 >> 8) & 0xFF;
     bytes[3] = addr2 & 0xFF;
-    gpio_set_level(dev->_dc, SPI_DATA_MODE);
-    return spi_master_write_bytes( dev->_SPIHandle, bytes, 4);
+    return spi_master_write_bytes(dev, SPI_DATA_MODE, bytes, 4);
 }
 
-uint16_t spi_master_write_packet(TFT_t * dev, uint16_t color, uint16_t size)
+/**
+ * @brief Queue a command with its parameters as one batch
+ *
+ * @param dev
+ * @param cmd
+ * @param data parameters, may be NULL when len is 0
+ * @param len
+ * @return true
+ */
+bool spi_master_write_cmd_data(TFT_t *dev, uint8_t cmd, const uint8_t *data, size_t len)
 {
-    spi_transaction_t SPITransaction;
+    spi_master_write_command(dev, cmd);
+    if (len > 0) {
+        spi_master_write_bytes(dev, SPI_DATA_MODE, data, len);
+    }
+    return true;
+}
+
+/**
+ * @brief Queue the window setup for a region, skipping what the panel already has.
+ *
+ * A write that starts exactly where the previous one stopped, within the same columns,
+ * continues with RAMWRC only. Otherwise CASET and RASET are sent only for ranges that
+ * changed, followed by RAMWR.
+ *
+ * @param dev
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ */
+void spi_master_set_window(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+    uint8_t cmd;
+    // Panel coordinates to memory addresses
+    x1 += dev->_offsetx;
+    x2 += dev->_offsetx;
+    y1 += dev->_offsety;
+    y2 += dev->_offsety;
+    bool sameCols = dev->_win_valid && dev->_win_x1 == x1 && dev->_win_x2 == x2;
+    bool sameRows = dev->_win_valid && dev->_win_y1 == y1 && dev->_win_y2 == y2;
+
+    if (sameCols && dev->_win_pos > 0) {
+        uint16_t cols = x2 - x1 + 1;
+        // The write pointer is at the start of row y1 and the region fits into the cached rows
+        if (dev->_win_pos % cols == 0 && y1 == dev->_win_y1 + dev->_win_pos / cols && y2 <= dev->_win_y2) {
+            cmd = LCD_CMD_RAMWRC;
+            spi_master_write_bytes(dev, SPI_CMD_MODE, &cmd, 1);
+            dev->_win_stats.hits++;
+            dev->_win_stats.continued++;
+            return;
+        }
+    }
 
-    gpio_set_level(dev->_dc, SPI_DATA_MODE);
-    // Swapping bytes in a word
-    uint8_t color_lb = color;
-    uint8_t color_hb = color >> 8;
+    if (!sameCols) {
+        cmd = LCD_CMD_CASET; // set column(x) address
+        spi_master_write_bytes(dev, SPI_CMD_MODE, &cmd, 1);
+        spi_master_write_addr(dev, x1, x2);
+    }
+    if (!sameRows) {
+        cmd = LCD_CMD_RASET; // set Page(y) address
+        spi_master_write_bytes(dev, SPI_CMD_MODE, &cmd, 1);
+        spi_master_write_addr(dev, y1, y2);
+    }
+    cmd = LCD_CMD_RAMWR; // Memory Write
+    spi_master_write_bytes(dev, SPI_CMD_MODE, &cmd, 1);
+
+    if (sameCols && sameRows) {
+        dev->_win_stats.hits++;
+    } else if (sameCols || sameRows) {
+        dev->_win_stats.partial++;
+    } else {
+        dev->_win_stats.misses++;
+    }
 
-    uint16_t len;
-    uint16_t total = 0;
-    for (uint16_t p = 0; p < size; p += MAX_WRITE_BUFF_COLORS) {
-        len = (size - p) > MAX_WRITE_BUFF_COLORS ? MAX_WRITE_BUFF_COLORS : (size - p);
+    dev->_win_valid = true;
+    dev->_win_x1 = x1;
+    dev->_win_x2 = x2;
+    dev->_win_y1 = y1;
+    dev->_win_y2 = y2;
+    dev->_win_pos = 0;
+}
 
-        for(int i = 0; i < len * 2; i += 2) {
-            write_buff[i]   = color_hb;
-            write_buff[i+1] = color_lb;
+/**
+ * @brief Track the panel write pointer after pixels were queued. It wraps to the window start at the end.
+ *
+ * @param dev
+ * @param pixels
+ */
+static void spi_master_window_advance(TFT_t *dev, uint32_t pixels)
+{
+    if (!dev->_win_valid) return;
+
+    uint32_t area = (uint32_t)(dev->_win_x2 - dev->_win_x1 + 1) * (dev->_win_y2 - dev->_win_y1 + 1);
+    dev->_win_pos = (dev->_win_pos + pixels) % area;
+}
+
+/**
+ * @brief Get a DMA pattern of a color with at least len bytes. A cached pattern is reused as is,
+ * otherwise the least recently used one is rewritten once its transfers are finished.
+ *
+ * @param dev
+ * @param color
+ * @param len bytes needed, a multiple of 4 up to diplayBufferLen
+ * @return lcd_fill_t*
+ */
+static lcd_fill_t *spi_master_fill_pattern(TFT_t *dev, uint16_t color, uint32_t len)
+{
+    lcd_fill_t *fill = NULL;
+    lcd_fill_t *lru = &dev->_fill[0];
+    for (uint8_t i = 0; i < dev->_fill_count; i++) {
+        if (dev->_fill[i].len > 0 && dev->_fill[i].color == color) {
+            fill = &dev->_fill[i];
+            break;
+        }
+        if (dev->_fill[i].lastUse < lru->lastUse) {
+            lru = &dev->_fill[i];
         }
-        
-        memset(&SPITransaction, 0, sizeof(spi_transaction_t));
-        SPITransaction.length = len * 16; // bits in a packet
-        SPITransaction.tx_buffer = write_buff;
+    }
 
-        esp_err_t ret = spi_device_transmit(dev->_SPIHandle, &SPITransaction);
-        assert(ret==ESP_OK);
-        total += len;
+    if (fill == NULL) {
+        fill = lru;
+        spi_master_wait_seq(dev, fill->seq);
+        fill->color = color;
+        fill->len = 0;
+    }
+    fill->lastUse = ++dev->_fill_clock;
+
+    // Queued transfers only read the bytes that were already there, extending the pattern is safe
+    if (fill->len < len) {
+        // Swapping bytes in a word, two colors per 32-bit store
+        uint8_t color_lb = color;
+        uint8_t color_hb = color >> 8;
+        uint8_t pair[4] = { color_hb, color_lb, color_hb, color_lb };
+        uint32_t word;
+        memcpy(&word, pair, sizeof(word));
+
+        uint32_t *buff = (uint32_t *)fill->buff;
+        for (uint32_t i = fill->len / 4; i < len / 4; i++) {
+            buff[i] = word;
+        }
+        fill->len = len;
     }
+    return fill;
+}
 
-    return total;
+uint32_t spi_master_write_packet(TFT_t * dev, uint16_t color, uint32_t size)
+{
+    spi_master_window_advance(dev, size);
+
+    // One or two pixels fit into the transaction itself
+    if (size <= 2) {
+        // Swapping bytes in a word
+        uint8_t color_lb = color;
+        uint8_t color_hb = color >> 8;
+        uint8_t bytes[4] = { color_hb, color_lb, color_hb, color_lb };
+        spi_master_write_bytes(dev, SPI_DATA_MODE, bytes, size * 2);
+        return size;
+    }
+
+    // The pattern is built once, every chunk of the fill is queued from the same buffer
+    uint32_t len = size * 2;
+    uint32_t patternLen = len < dev->diplayBufferLen ? (len + 3) & ~3 : dev->diplayBufferLen;
+    lcd_fill_t *fill = spi_master_fill_pattern(dev, color, patternLen);
+
+    for (uint32_t p = 0; p < len; p += patternLen) {
+        uint32_t chunk = (len - p) > patternLen ? patternLen : (len - p);
+        spi_master_queue_data(dev, fill->buff, chunk);
+    }
+    fill->seq = dev->_trans_queued;
+
+    return size;
 }
 
 /**
@@ -178,7 +670,8 @@ uint16_t spi_master_write_packet(TFT_t * dev, uint16_t color, uint16_t size)
  */
 uint16_t spi_master_read_packet(TFT_t *dev, uint16_t *colors, uint16_t size)
 {
-    gpio_set_level(dev->_dc, SPI_DATA_MODE);
+    // Reading is blocking, queued writes have to be sent first
+    spi_master_wait(dev);
 
     //ESP_LOG_BUFFER_HEX("colors input", colors, size);
     ESP_LOGD("size", "size: %d", size);
@@ -192,6 +685,7 @@ uint16_t spi_master_read_packet(TFT_t *dev, uint16_t *colors, uint16_t size)
     //SPITransaction.rxlength = size * 16; // bits in a packet
     SPITransaction.tx_buffer = NULL;
     SPITransaction.rx_buffer = colors;
+    SPITransaction.user = &dev->_dc_mode[SPI_DATA_MODE];
 
     esp_err_t ret = spi_device_transmit( dev->_SPIHandle, &SPITransaction );
     assert(ret==ESP_OK);
@@ -203,37 +697,201 @@ uint16_t spi_master_read_packet(TFT_t *dev, uint16_t *colors, uint16_t size)
     return SPITransaction.rxlength / 16;
 }
 
-uint16_t spi_master_write_colors(TFT_t * dev, uint16_t *colors, uint16_t size)
+/**
+ * @brief Send a read command and take its reply in one half-duplex transaction, so CS stays
+ * active from the command byte to the last reply bit
+ *
+ * @param dev
+ * @param cmd
+ * @param dummyBits clock cycles the panel takes before it replies
+ * @param rx reply
+ * @param len bytes of the reply, up to 4
+ * @return esp_err_t error of the SPI driver, e.g. for a device without SPI_DEVICE_HALFDUPLEX
+ */
+static esp_err_t spi_master_read_command(TFT_t *dev, uint8_t cmd, uint8_t dummyBits, uint8_t *rx, size_t len)
 {
-    spi_transaction_t SPITransaction;
+    // Reading is blocking, queued writes have to be sent first
+    spi_master_wait(dev);
+    dev->_win_valid = false;
+
+    spi_transaction_ext_t trans;
+    memset(&trans, 0, sizeof(spi_transaction_ext_t));
+    trans.base.flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_DUMMY;
+    trans.base.cmd = cmd;
+    trans.base.rxlength = len * 8; // in bits
+    // D/C is sampled with the command byte only, the reply ignores it
+    trans.base.user = &dev->_dc_mode[SPI_CMD_MODE];
+    trans.command_bits = 8;
+    trans.dummy_bits = dummyBits;
+
+    esp_err_t ret = spi_device_transmit(dev->_SPIHandle, &trans.base);
+    if (ret != ESP_OK) return ret;
+    memcpy(rx, trans.base.rx_data, len);
+    return ESP_OK;
+}
 
-    gpio_set_level(dev->_dc, SPI_DATA_MODE);
+uint32_t spi_master_write_colors(TFT_t * dev, uint16_t *colors, uint32_t size)
+{
+    spi_master_window_advance(dev, size);
 
-    uint16_t len;
-    uint16_t total = 0;
-    uint16_t colorIndex = 0;
-    for (uint16_t p = 0; p < size; p += MAX_WRITE_BUFF_COLORS) {
-        len = (size - p) > MAX_WRITE_BUFF_COLORS ? MAX_WRITE_BUFF_COLORS : (size - p);
+    uint32_t chunkColors = dev->_chunk_len / 2;
+    uint32_t len;
+    uint32_t total = 0;
+    uint32_t colorIndex = 0;
+    for (uint32_t p = 0; p < size; p += chunkColors) {
+        len = (size - p) > chunkColors ? chunkColors : (size - p);
 
+        uint8_t *buff = spi_master_next_buff(dev);
         for(int i = 0; i < len * 2; i += 2) {
             // Swapping bytes in a word
-            write_buff[i]   = colors[colorIndex] >> 8;
-            write_buff[i+1] = colors[colorIndex] & 0xFF;
+            buff[i]   = colors[colorIndex] >> 8;
+            buff[i+1] = colors[colorIndex] & 0xFF;
             colorIndex++;
         }
 
-        memset( &SPITransaction, 0, sizeof( spi_transaction_t ) );
-        SPITransaction.length = len * 16; // bits in a packet
-        SPITransaction.tx_buffer = write_buff;
-
-        esp_err_t ret = spi_device_transmit(dev->_SPIHandle, &SPITransaction);
-        assert(ret==ESP_OK);
+        spi_master_queue_buff(dev, buff, len * 2);
         total += len;
     }
 
     return total;
 }
 
+/**
+ * @brief Send rows of big-endian colors that are not contiguous in memory, packed into the DMA ring
+ *
+ * @param dev
+ * @param data first pixel of the first row
+ * @param cols pixels in a row
+ * @param rows
+ * @param stride pixels from one row to the next
+ */
+static void spi_master_write_rows(TFT_t *dev, const uint16_t *data, uint16_t cols, uint16_t rows, uint16_t stride)
+{
+    spi_master_window_advance(dev, (uint32_t)cols * rows);
+
+    uint8_t *buff = NULL;
+    size_t used = 0;
+    for (uint16_t row = 0; row < rows; row++) {
+        const uint8_t *src = (const uint8_t *)(data + (size_t)row * stride);
+        size_t len = cols * 2;
+        while (len > 0) {
+            if (buff == NULL) {
+                buff = spi_master_next_buff(dev);
+                used = 0;
+            }
+            size_t part = len < dev->_chunk_len - used ? len : dev->_chunk_len - used;
+            memcpy(buff + used, src, part);
+            used += part;
+            src += part;
+            len -= part;
+            if (used == dev->_chunk_len) {
+                spi_master_queue_buff(dev, buff, used);
+                buff = NULL;
+            }
+        }
+    }
+    if (buff != NULL) {
+        spi_master_queue_buff(dev, buff, used);
+    }
+}
+
+/**
+ * @brief Measure the per-transaction overhead with NOP commands and size chunks so the overhead
+ * stays at a small fraction of the wire time of a chunk
+ *
+ * @param dev
+ */
+static void spi_master_calibrate_chunk(TFT_t *dev)
+{
+    if (dev->_clock_hz <= 0) return;
+
+    spi_master_wait(dev);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < CALIBRATION_TRANS; i++) {
+        spi_master_write_command(dev, LCD_CMD_NOP);
+    }
+    spi_master_wait(dev);
+    int64_t overheadUs = (esp_timer_get_time() - start) / CALIBRATION_TRANS;
+
+    // Bytes clocked out during one overhead period, times the wanted wire/overhead ratio
+    uint64_t chunk = (uint64_t)overheadUs * dev->_clock_hz / 8 / 1000000 * CHUNK_OVERHEAD_RATIO;
+    if (chunk < MIN_CHUNK_LEN) {
+        chunk = MIN_CHUNK_LEN;
+    }
+    if (chunk > dev->diplayBufferLen) {
+        chunk = dev->diplayBufferLen;
+    }
+    dev->_chunk_len = chunk & ~3;
+
+    ESP_LOGI(TAG, "transaction overhead %d us, chunk %d bytes", (int)overheadUs, (int)dev->_chunk_len);
+}
+
+/**
+ * @brief TE rising edge: the panel starts a new refresh
+ *
+ * @param arg device
+ */
+static void IRAM_ATTR lcd_te_isr_handler(void *arg)
+{
+    TFT_t *dev = (TFT_t *)arg;
+    int64_t now = esp_timer_get_time();
+
+    // An edge lost to a long critical section would double the period, such samples are skipped
+    int64_t period = now - dev->_te_time;
+    if (dev->_te_time != 0 && period < dev->_frame_us * 3 / 2) {
+        dev->_frame_us = period;
+    }
+    dev->_te_time = now;
+    dev->_te_count++;
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(dev->_te_sem, &woken);
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/**
+ * @brief Set up the refresh synchronization of display_config_t.frameSync
+ *
+ * @param dev
+ * @param display_config
+ */
+static void lcd_sync_init(TFT_t *dev, display_config_t *display_config)
+{
+    dev->_sync = display_config->frameSync;
+    dev->_te = -1;
+    dev->_te_sem = NULL;
+    dev->_te_time = 0;
+    dev->_te_count = 0;
+    dev->_frame_us = DEFAULT_FRAME_US;
+    dev->_sync_vsyncs = 0;
+    dev->_sync_time = 0;
+    memset(&dev->_frame_stats, 0, sizeof(lcd_frame_stats_t));
+    dev->_frame_stats.minSlackUs = INT32_MAX;
+
+    if (dev->_sync != LCD_SYNC_TE_PIN) return;
+
+    dev->_te_sem = xSemaphoreCreateBinary();
+    assert(dev->_te_sem != NULL);
+    dev->_te = display_config->pinTE;
+
+    gpio_reset_pin(display_config->pinTE);
+    gpio_set_direction(display_config->pinTE, GPIO_MODE_INPUT);
+    gpio_set_intr_type(display_config->pinTE, GPIO_INTR_POSEDGE);
+    // The service may already be installed by the application or another display
+    esp_err_t ret = gpio_install_isr_service(0);
+    assert(ret==ESP_OK || ret==ESP_ERR_INVALID_STATE);
+    ret = gpio_isr_handler_add(display_config->pinTE, lcd_te_isr_handler, dev);
+    assert(ret==ESP_OK);
+
+    static const uint8_t line[2] = { 0x00, 0x00 };
+    spi_master_write_cmd_data(dev, LCD_CMD_STE, line, sizeof(line)); // Pulse when line 0 starts
+    spi_master_write_command(dev, LCD_CMD_TEON);
+    spi_master_write_data_byte(dev, 0x00);                           // V-blank information only
+    spi_master_wait(dev);
+}
+
 /**
  * @brief Initialize a lcd device with a config
  *
@@ -248,10 +906,23 @@ void lcdInit(TFT_t *dev, display_config_t *display_config, spi_device_interface_
     dev->maxY = display_config->height - 1;
     dev->_offsetx = 0;
     dev->_offsety = 0;
+    dev->_rotation = DIRECTION0;
     dev->_font_direction = DIRECTION0;
     dev->_font_fill = false;
     dev->_font_underline = false;
-    dev->diplayBufferLen = WRITE_BUFF_LEN;
+    dev->_fb = NULL;
+    memset(&dev->_frame, 0, sizeof(lcd_framebuffer_t));
+    dev->_bands = NULL;
+    dev->_capture = NULL;
+    dev->_scroll_top = 0;
+    dev->_scroll_height = 0;
+    dev->_scroll_pos = 0;
+    dev->_service = NULL;
+    dev->_lock = NULL;
+    if (display_config->locking) {
+        dev->_lock = xSemaphoreCreateRecursiveMutex();
+        assert(dev->_lock != NULL);
+    }
 
     spi_master_init(dev, display_config, spiInterfaceConfig);
 
@@ -290,29 +961,1811 @@ void lcdInit(TFT_t *dev, display_config_t *display_config, spi_device_interface_
     spi_master_write_command(dev, LCD_CMD_DISPON);	//Display ON
     delayMS(255);
 
+    if (display_config->adaptiveChunk) {
+        spi_master_calibrate_chunk(dev);
+    }
+
+    lcd_sync_init(dev, display_config);
+
     if(dev->_bl >= 0) {
         gpio_set_level( dev->_bl, 1 );
     }
 }
 
+/**
+ * @brief Release everything lcdInit() set up: the service task, framebuffer and bands, DMA and
+ * fill buffers, the TE interrupt and the SPI device, and the bus with its last panel. What is
+ * still queued is sent first.
+ *
+ * @param dev
+ */
+void lcdDeinit(TFT_t *dev)
+{
+    lcdStopService(dev);
+    lcdUnsetBands(dev);
+    lcdUnsetFramebuffer(dev);
+    spi_master_wait(dev);
+
+    if (dev->_te >= 0) {
+        gpio_isr_handler_remove(dev->_te);
+        dev->_te = -1;
+    }
+    if (dev->_te_sem != NULL) {
+        vSemaphoreDelete(dev->_te_sem);
+        dev->_te_sem = NULL;
+    }
 
-// Draw pixel
-// x:X coordinate
-// y:Y coordinate
+    for (uint8_t i = 0; i < dev->_dma_count; i++) {
+        heap_caps_free(dev->_dma_buff[i]);
+        dev->_dma_buff[i] = NULL;
+    }
+    dev->_dma_count = 0;
+    for (uint8_t i = 0; i < dev->_fill_count; i++) {
+        heap_caps_free(dev->_fill[i].buff);
+        dev->_fill[i].buff = NULL;
+    }
+    dev->_fill_count = 0;
+    for (uint8_t i = 0; i < dev->_glyph_count; i++) {
+        heap_caps_free(dev->_glyph_cache[i].pixels);
+        dev->_glyph_cache[i].pixels = NULL;
+    }
+    dev->_glyph_count = 0;
+    heap_caps_free(dev->_strip);
+    dev->_strip = NULL;
+    dev->_strip_len = 0;
+
+    spi_bus_remove_device(dev->_SPIHandle);
+    dev->_SPIHandle = NULL;
+    lcd_bus_t *bus = &buses[dev->_host];
+    if (--bus->users == 0) {
+        if (bus->owned) spi_bus_free(dev->_host);
+        bus->unselected = false;
+    }
+
+    if (dev->_lock != NULL) {
+        vSemaphoreDelete(dev->_lock);
+        dev->_lock = NULL;
+    }
+}
+
+/**
+ * @brief The calling task has to take the device lock. The service task owns the panel and
+ * never waits for it: a task holding the lock may be waiting for room in the service queue.
+ *
+ * @param dev
+ * @return bool
+ */
+static bool lcd_lock_needed(TFT_t *dev)
+{
+    if (dev->_lock == NULL) return false;
+    return dev->_service == NULL || xTaskGetCurrentTaskHandle() != dev->_service->task;
+}
+
+/**
+ * @brief Take the device for a sequence of calls, e.g. a font setting and the text drawn with it.
+ * Drawing calls take it themselves. Nests, and does nothing without display_config_t.locking.
+ *
+ * @param dev
+ */
+void lcdLock(TFT_t *dev)
+{
+    if (lcd_lock_needed(dev)) {
+        xSemaphoreTakeRecursive(dev->_lock, portMAX_DELAY);
+    }
+}
+
+/**
+ * @brief Give back the device taken by lcdLock()
+ *
+ * @param dev
+ */
+void lcdUnlock(TFT_t *dev)
+{
+    if (lcd_lock_needed(dev)) {
+        xSemaphoreGiveRecursive(dev->_lock);
+    }
+}
+
+
+/**
+ * @brief A call from another task while the service task runs, it has to go through the queue
+ *
+ * @param dev
+ * @return bool
+ */
+static bool lcd_service_remote(TFT_t *dev)
+{
+    return dev->_service != NULL && xTaskGetCurrentTaskHandle() != dev->_service->task;
+}
+
+/**
+ * @brief Capture hook of the calling context: the service task keeps its own, so a band
+ * frame it records does not take the calls of other tasks
+ *
+ * @param dev
+ * @return lcd_capture_t*
+ */
+static lcd_capture_t *lcd_capture_hook(TFT_t *dev)
+{
+    if (dev->_service != NULL && !lcd_service_remote(dev)) return &dev->_service->capture;
+    return &dev->_capture;
+}
+
+/**
+ * @brief Put a call in the service queue, lock-free
+ *
+ * @param svc
+ * @param cmd
+ * @param data copied into the entry and used as cmd->ptr, NULL to keep cmd->ptr
+ * @param len
+ * @return false when the queue is full
+ */
+static bool lcd_service_push(struct lcd_service *svc, const lcd_cmd_t *cmd, const void *data, size_t len)
+{
+    lcd_service_slot_t *slot;
+    uint32_t pos = atomic_load_explicit(&svc->head, memory_order_relaxed);
+    for (;;) {
+        slot = &svc->slots[pos & svc->mask];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&svc->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            // The entry still holds the call from one lap ago
+            return false;
+        } else {
+            pos = atomic_load_explicit(&svc->head, memory_order_relaxed);
+        }
+    }
+
+    slot->cmd = *cmd;
+    if (data != NULL) {
+        memcpy(slot->data, data, len);
+        slot->cmd.ptr = slot->data;
+    }
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    // Pairs with the fence of the task between setting sleeping and looking at the queue again
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&svc->sleeping, memory_order_relaxed)) {
+        xTaskNotifyGive(svc->task);
+    }
+    return true;
+}
+
+/**
+ * @brief Queue a call to the service task, waiting for room while the queue is full
+ *
+ * @param dev
+ * @param cmd
+ * @param data see lcd_service_push()
+ * @param len
+ */
+static void lcd_service_send(TFT_t *dev, const lcd_cmd_t *cmd, const void *data, size_t len)
+{
+    struct lcd_service *svc = dev->_service;
+    if (lcd_service_push(svc, cmd, data, len)) return;
+
+    atomic_fetch_add(&svc->stalls, 1);
+    atomic_fetch_add(&svc->waiting, 1);
+    while (!lcd_service_push(svc, cmd, data, len)) {
+        // A timeout, not only the semaphore: one give may be taken by another waiting producer
+        xSemaphoreTake(svc->space, 1);
+    }
+    atomic_fetch_sub(&svc->waiting, 1);
+}
+
+/**
+ * @brief Wait until the service task ran every call queued so far
+ *
+ * @param dev
+ * @param sent also wait until their transfers are done
+ */
+static void lcd_service_fence(TFT_t *dev, bool sent)
+{
+    StaticSemaphore_t buffer;
+    SemaphoreHandle_t done = xSemaphoreCreateBinaryStatic(&buffer);
+    lcd_cmd_t cmd = { .op = LCD_OP_FENCE, .arg = { sent }, .ptr = done };
+    lcd_service_send(dev, &cmd, NULL, 0);
+    xSemaphoreTake(done, portMAX_DELAY);
+    vSemaphoreDelete(done);
+}
+
+/**
+ * @brief Hand a call of another task to the service task
+ *
+ * @param dev
+ * @param cmd
+ * @param wait return only when the call ran and its transfers are done
+ * @return false when the caller runs the call itself
+ */
+static bool lcd_service_defer(TFT_t *dev, const lcd_cmd_t *cmd, bool wait)
+{
+    if (!lcd_service_remote(dev)) return false;
+    lcd_service_send(dev, cmd, NULL, 0);
+    if (wait) lcd_service_fence(dev, true);
+    return true;
+}
+
+/**
+ * @brief Arguments and result of a call another task hands to lcd_service_run()
+ */
+typedef struct {
+    TFT_t *dev;
+    uint32_t arg[5];
+    void *ptr;
+    int ret;
+} lcd_remote_call_t;
+
+/**
+ * @brief Arrays of a lcdDrawPixelBatch() call another task hands to the service task
+ */
+typedef struct {
+    lcd_point_t *points;
+    uint16_t *colors;
+} lcd_batch_t;
+
+/**
+ * @brief Run fn(arg) on the service task and wait for it, for calls of other tasks that
+ * set up the panel or read it back and have no command in the queue
+ *
+ * @param dev
+ * @param fn
+ * @param arg may live on the stack of the caller
+ * @return false when the caller runs the call itself
+ */
+static bool lcd_service_run(TFT_t *dev, lcd_done_cb_t fn, void *arg)
+{
+    lcd_cmd_t cmd = { .op = LCD_OP_CALL, .doneCb = fn, .doneArg = arg };
+    return lcd_service_defer(dev, &cmd, true);
+}
+
+/**
+ * @brief Bytes behind cmd->ptr that a recorded call has to keep
+ *
+ * @param cmd
+ * @return size_t 0 for calls without data, or whose buffer stays the caller's (lcdDrawPixelsDMA)
+ */
+static size_t lcd_cmd_data_len(const lcd_cmd_t *cmd)
+{
+    switch (cmd->op) {
+    case LCD_OP_PIXELS:
+        return cmd->arg[4] * 2;
+    case LCD_OP_FILL_POLYGON:
+    case LCD_OP_POLYLINE:
+        return cmd->arg[0] * sizeof(lcd_point_t);
+    case LCD_OP_STRING:
+    case LCD_OP_STRING_S:
+    case LCD_OP_STRING_PAD:
+        return strlen(cmd->ptr) + 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Capture hook while the service task runs. Calls of other tasks are queued with
+ * a copy of their colors or text, calls of the task itself go to its own hook.
+ *
+ * @param dev
+ * @param cmd
+ * @return false when the call has to run now
+ */
+static bool lcd_service_capture(void *dev, const lcd_cmd_t *cmd)
+{
+    TFT_t *_dev = dev;
+    struct lcd_service *svc = _dev->_service;
+    if (!lcd_service_remote(_dev)) {
+        return svc->capture != NULL && svc->capture(dev, cmd);
+    }
+
+    size_t len = lcd_cmd_data_len(cmd);
+    if (len > SERVICE_INLINE) {
+        // The caller may reuse its buffer once the call returns, so it waits until the call ran
+        atomic_fetch_add(&svc->inlineMiss, 1);
+        lcd_service_send(_dev, cmd, NULL, 0);
+        lcd_service_fence(_dev, false);
+        return true;
+    }
+    lcd_service_send(_dev, cmd, len > 0 ? cmd->ptr : NULL, len);
+    return true;
+}
+
+
+/**
+ * @brief Map screen rows y1..y2 to panel memory rows through the hardware scroll offset.
+ * Rows of the scroll area continue in memory up to its end and then wrap to its start,
+ * so a range can come back in up to four spans: fixed top, two scrolled parts, fixed bottom.
+ *
+ * @param dev
+ * @param y1
+ * @param y2
+ * @param spans room for 4
+ * @return uint8_t spans filled
+ */
+static uint8_t lcd_scroll_spans(TFT_t *dev, uint16_t y1, uint16_t y2, lcd_span_t *spans)
+{
+    if (dev->_scroll_height == 0) {
+        spans[0].y = y1;
+        spans[0].row = y1;
+        spans[0].rows = y2 - y1 + 1;
+        return 1;
+    }
+
+    uint16_t top = dev->_scroll_top;
+    uint16_t end = top + dev->_scroll_height;
+    uint8_t count = 0;
+    for (uint16_t y = y1; y <= y2; ) {
+        uint16_t last = y2;
+        uint16_t row = y;
+        if (y < top) {
+            if (last > top - 1) last = top - 1;
+        } else if (y < end) {
+            uint16_t offset = (y - top + dev->_scroll_pos) % dev->_scroll_height;
+            row = top + offset;
+            if (last > end - 1) last = end - 1;
+            if (last > y + (dev->_scroll_height - offset) - 1) last = y + (dev->_scroll_height - offset) - 1;
+        }
+        spans[count].y = y;
+        spans[count].row = row;
+        spans[count].rows = last - y + 1;
+        count++;
+        y = last + 1;
+    }
+    return count;
+}
+
+static void lcd_scroll_area_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    call->ret = lcdSetScrollArea(call->dev, call->arg[0], call->arg[1]);
+}
+
+/**
+ * @brief Set up hardware vertical scrolling. Rows above and below the area stay fixed.
+ * Drawing calls keep using screen coordinates, rows inside the area are translated to
+ * where the scroll offset shows them.
+ *
+ * @param dev
+ * @param top first row of the scroll area
+ * @param height rows of the scroll area, 0 to turn scrolling off
+ * @return esp_err_t ESP_ERR_INVALID_STATE for a scroll area under another orientation than
+ * DIRECTION0: the panel scrolls its memory lines, which are not screen rows then
+ */
+esp_err_t lcdSetScrollArea(TFT_t *dev, uint16_t top, uint16_t height)
+{
+    lcd_remote_call_t call = { .dev = dev, .arg = { top, height } };
+    if (lcd_service_run(dev, lcd_scroll_area_call, &call)) return call.ret;
+
+    // Under MV the lines are screen columns, under MY they run from the bottom up
+    if (height > 0 && dev->_rotation != DIRECTION0) return ESP_ERR_INVALID_STATE;
+    if (top >= dev->_height) {
+        height = 0;
+    }
+    if (height > dev->_height - top) {
+        height = dev->_height - top;
+    }
+
+    // Unused panel memory below the screen belongs to the bottom fixed area
+    uint16_t tfa = height > 0 ? dev->_offsety + top : 0;
+    uint16_t vsa = height > 0 ? height : GRAM_LINES;
+    uint16_t bfa = GRAM_LINES - tfa - vsa;
+    uint8_t data[6] = { tfa >> 8, tfa & 0xFF, vsa >> 8, vsa & 0xFF, bfa >> 8, bfa & 0xFF };
+    lcdLock(dev);
+    spi_master_write_cmd_data(dev, LCD_CMD_VSCRDEF, data, sizeof(data));
+
+    dev->_scroll_top = top;
+    dev->_scroll_height = height;
+    dev->_scroll_pos = 0;
+    spi_master_write_command(dev, LCD_CMD_VSCSAD);
+    spi_master_write_data_word(dev, tfa);
+    lcdUnlock(dev);
+    return ESP_OK;
+}
+
+/**
+ * @brief Scroll the area of lcdSetScrollArea(): the first row of the area shows its line
+ * `line`, the lines before it wrap around to the bottom. After scrolling by n lines only the
+ * n rows that came into view at the bottom of the area need to be drawn.
+ *
+ * @param dev
+ * @param line
+ */
+void lcdScrollTo(TFT_t *dev, uint16_t line)
+{
+    lcd_cmd_t cmd = { .op = LCD_OP_SCROLL, .arg = { line } };
+    if (lcd_service_defer(dev, &cmd, false)) return;
+    if (dev->_scroll_height == 0) return;
+
+    lcdLock(dev);
+    dev->_scroll_pos = line % dev->_scroll_height;
+    spi_master_write_command(dev, LCD_CMD_VSCSAD);
+    spi_master_write_data_word(dev, dev->_offsety + dev->_scroll_top + dev->_scroll_pos);
+    lcdUnlock(dev);
+}
+
+static uint32_t lcd_rect_area(const lcd_rect_t *r)
+{
+    return (uint32_t)(r->x2 - r->x1 + 1) * (r->y2 - r->y1 + 1);
+}
+
+/**
+ * @brief Smallest rectangle covering a and b
+ *
+ * @param a
+ * @param b
+ * @return lcd_rect_t
+ */
+static lcd_rect_t lcd_rect_union(const lcd_rect_t *a, const lcd_rect_t *b)
+{
+    lcd_rect_t u = {
+        .x1 = a->x1 < b->x1 ? a->x1 : b->x1,
+        .y1 = a->y1 < b->y1 ? a->y1 : b->y1,
+        .x2 = a->x2 > b->x2 ? a->x2 : b->x2,
+        .y2 = a->y2 > b->y2 ? a->y2 : b->y2,
+    };
+    return u;
+}
+
+/**
+ * @brief Pixels the union of a and b covers that neither a nor b does, i.e. what merging them costs
+ *
+ * @param a
+ * @param b
+ * @return uint32_t
+ */
+static uint32_t lcd_rect_waste(const lcd_rect_t *a, const lcd_rect_t *b)
+{
+    lcd_rect_t u = lcd_rect_union(a, b);
+    uint32_t covered = lcd_rect_area(a) + lcd_rect_area(b);
+
+    int ix1 = a->x1 > b->x1 ? a->x1 : b->x1;
+    int iy1 = a->y1 > b->y1 ? a->y1 : b->y1;
+    int ix2 = a->x2 < b->x2 ? a->x2 : b->x2;
+    int iy2 = a->y2 < b->y2 ? a->y2 : b->y2;
+    if (ix1 <= ix2 && iy1 <= iy2) {
+        covered -= (uint32_t)(ix2 - ix1 + 1) * (iy2 - iy1 + 1);
+    }
+    return lcd_rect_area(&u) - covered;
+}
+
+/**
+ * @brief Whether a and b overlap or share an edge
+ *
+ * @param a
+ * @param b
+ * @return true
+ * @return false
+ */
+static bool lcd_rect_touch(const lcd_rect_t *a, const lcd_rect_t *b)
+{
+    return a->x1 <= b->x2 + 1 && b->x1 <= a->x2 + 1
+        && a->y1 <= b->y2 + 1 && b->y1 <= a->y2 + 1;
+}
+
+/**
+ * @brief Add a changed region to the dirty list of a framebuffer. Overlapping or adjacent
+ * rectangles are merged when the union resends few unchanged pixels, a full list merges
+ * the pair that wastes the least.
+ *
+ * @param fb
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ */
+static void lcd_fb_mark(lcd_framebuffer_t *fb, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
+{
+    if (!fb->tracked) return;
+
+    lcd_rect_t rect = { .x1 = x1, .y1 = y1, .x2 = x2, .y2 = y2 };
+
+    uint8_t i = 0;
+    while (i < fb->dirtyCount) {
+        lcd_rect_t *dirty = &fb->dirty[i];
+        uint32_t waste = lcd_rect_waste(dirty, &rect);
+        uint32_t smaller = lcd_rect_area(dirty) < lcd_rect_area(&rect) ? lcd_rect_area(dirty) : lcd_rect_area(&rect);
+        if (waste <= FB_MERGE_SLACK || (lcd_rect_touch(dirty, &rect) && waste <= smaller)) {
+            // The grown rectangle may reach others now, so the scan starts over
+            rect = lcd_rect_union(dirty, &rect);
+            *dirty = fb->dirty[--fb->dirtyCount];
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+
+    while (fb->dirtyCount == LCD_DIRTY_RECTS_MAX) {
+        uint8_t best = 0;
+        uint32_t bestWaste = UINT32_MAX;
+        for (i = 0; i < fb->dirtyCount; i++) {
+            uint32_t waste = lcd_rect_waste(&fb->dirty[i], &rect);
+            if (waste < bestWaste) {
+                bestWaste = waste;
+                best = i;
+            }
+        }
+        rect = lcd_rect_union(&fb->dirty[best], &rect);
+        fb->dirty[best] = fb->dirty[--fb->dirtyCount];
+    }
+
+    fb->dirty[fb->dirtyCount++] = rect;
+}
+
+/**
+ * @brief Clip a panel region to the part a framebuffer holds
+ *
+ * @param fb
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ * @return true when something is left
+ */
+static bool lcd_fb_clip(const lcd_framebuffer_t *fb, uint16_t *x1, uint16_t *y1, uint16_t *x2, uint16_t *y2)
+{
+    uint16_t fx2 = fb->x + fb->width - 1;
+    uint16_t fy2 = fb->y + fb->height - 1;
+    if (*x1 > fx2 || *x2 < fb->x || *y1 > fy2 || *y2 < fb->y) return false;
+
+    if (*x1 < fb->x) *x1 = fb->x;
+    if (*y1 < fb->y) *y1 = fb->y;
+    if (*x2 > fx2) *x2 = fx2;
+    if (*y2 > fy2) *y2 = fy2;
+    return true;
+}
+
+/**
+ * @brief Fill a panel region of the render target with one color
+ *
+ * @param fb
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ * @param color
+ */
+static void lcd_fb_fill(lcd_framebuffer_t *fb, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color)
+{
+    if (!lcd_fb_clip(fb, &x1, &y1, &x2, &y2)) return;
+
+    uint16_t value = RGB565_BE(color);
+    uint16_t cols = x2 - x1 + 1;
+    for (uint16_t y = y1; y <= y2; y++) {
+        uint16_t *dst = fb->pixels + (size_t)(y - fb->y) * fb->width + (x1 - fb->x);
+        for (uint16_t i = 0; i < cols; i++) {
+            dst[i] = value;
+        }
+    }
+    lcd_fb_mark(fb, x1, y1, x2, y2);
+}
+
+/**
+ * @brief Copy colors to a panel region of the render target
+ *
+ * @param fb
+ * @param x1 region the colors are laid out for, already clipped to the panel
+ * @param y1
+ * @param x2
+ * @param y2
+ * @param colors color of (x, y) is colors[(y - y1) * stride + (x - x1)]
+ * @param count colors available, later pixels are left untouched
+ * @param stride colors from one row to the next
+ * @param swap colors are in native order and have to be swapped to big-endian
+ */
+static void lcd_fb_copy(lcd_framebuffer_t *fb, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint16_t *colors, uint32_t count, uint32_t stride, bool swap)
+{
+    uint16_t _x1 = x1, _y1 = y1, _x2 = x2, _y2 = y2;
+    if (!lcd_fb_clip(fb, &_x1, &_y1, &_x2, &_y2)) return;
+
+    int lastRow = -1;
+    for (uint16_t y = _y1; y <= _y2; y++) {
+        uint32_t index = (uint32_t)(y - y1) * stride + (_x1 - x1);
+        if (index >= count) break;
+        uint32_t cols = _x2 - _x1 + 1;
+        if (cols > count - index) {
+            cols = count - index;
+        }
+
+        const uint16_t *src = colors + index;
+        uint16_t *dst = fb->pixels + (size_t)(y - fb->y) * fb->width + (_x1 - fb->x);
+        if (swap) {
+            for (uint32_t i = 0; i < cols; i++) {
+                dst[i] = RGB565_BE(src[i]);
+            }
+        } else {
+            memcpy(dst, src, cols * 2);
+        }
+        lastRow = y;
+    }
+    if (lastRow >= 0) {
+        lcd_fb_mark(fb, _x1, _y1, _x2, lastRow);
+    }
+}
+
+/**
+ * @brief Queue one region of a framebuffer to the panel. Full-width regions go out straight
+ * from the framebuffer, narrower ones are packed into the DMA ring.
+ *
+ * @param dev
+ * @param fb
+ * @param rect
+ */
+static void lcd_fb_send(TFT_t *dev, const lcd_framebuffer_t *fb, const lcd_rect_t *rect)
+{
+    uint16_t cols = rect->x2 - rect->x1 + 1;
+    uint16_t rows = rect->y2 - rect->y1 + 1;
+    const uint16_t *data = fb->pixels + (size_t)(rect->y1 - fb->y) * fb->width + (rect->x1 - fb->x);
+
+    spi_master_set_window(dev, rect->x1, rect->y1, rect->x2, rect->y2);
+    if (cols == fb->width) {
+        spi_master_window_advance(dev, (uint32_t)cols * rows);
+        spi_master_queue_long(dev, (const uint8_t *)data, (size_t)cols * rows * 2);
+    } else {
+        spi_master_write_rows(dev, data, cols, rows, fb->width);
+    }
+}
+
+/**
+ * @brief Queue the dirty regions of a framebuffer to the panel and clear the dirty list
+ *
+ * @param dev
+ * @param fb
+ */
+static void lcd_fb_flush(TFT_t *dev, lcd_framebuffer_t *fb)
+{
+    for (uint8_t i = 0; i < fb->dirtyCount; i++) {
+        lcd_fb_send(dev, fb, &fb->dirty[i]);
+    }
+    fb->dirtyCount = 0;
+}
+
+static void lcd_framebuffer_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    call->ret = lcdSetFramebuffer(call->dev, call->ptr);
+}
+
+/**
+ * @brief Render every following drawing call into a full-frame RAM buffer instead of the panel.
+ * Nothing reaches the panel until lcdFlush(). The buffer starts black.
+ *
+ * @param dev
+ * @param pixels buffer of width * height colors, NULL to allocate one. DMA-capable memory lets
+ * full-width regions be flushed without copying.
+ * @return esp_err_t ESP_ERR_NO_MEM when no buffer could be allocated
+ */
+esp_err_t lcdSetFramebuffer(TFT_t *dev, uint16_t *pixels)
+{
+    // The service task draws into the buffer, it is swapped between its calls
+    lcd_remote_call_t call = { .dev = dev, .ptr = pixels };
+    if (lcd_service_run(dev, lcd_framebuffer_call, &call)) return call.ret;
+
+    lcdUnsetFramebuffer(dev);
+
+    size_t len = (size_t)dev->_width * dev->_height * 2;
+    bool owned = false;
+    if (pixels == NULL) {
+        pixels = heap_caps_malloc(len, MALLOC_CAP_DMA);
+        if (pixels == NULL) {
+            // PSRAM or fragmented heap, the SPI driver bounces transfers through DMA memory then
+            pixels = heap_caps_malloc(len, MALLOC_CAP_8BIT);
+        }
+        if (pixels == NULL) {
+            ESP_LOGE(TAG, "no memory for a %dx%d framebuffer", dev->_width, dev->_height);
+            return ESP_ERR_NO_MEM;
+        }
+        owned = true;
+    }
+    memset(pixels, 0, len);
+
+    lcd_framebuffer_t *fb = &dev->_frame;
+    fb->pixels = pixels;
+    fb->x = 0;
+    fb->y = 0;
+    fb->width = dev->_width;
+    fb->height = dev->_height;
+    fb->owned = owned;
+    fb->tracked = true;
+    fb->dirtyCount = 0;
+    dev->_fb = fb;
+    return ESP_OK;
+}
+
+/**
+ * @brief Flush the framebuffer and go back to drawing straight to the panel
+ *
+ * @param dev
+ */
+void lcdUnsetFramebuffer(TFT_t *dev)
+{
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdUnsetFramebuffer, dev)) return;
+    if (dev->_fb == NULL) return;
+
+    lcdFlush(dev);
+    dev->_fb = NULL;
+    if (dev->_frame.owned) {
+        heap_caps_free(dev->_frame.pixels);
+    }
+    dev->_frame.pixels = NULL;
+}
+
+/**
+ * @brief Send what changed in the framebuffer since the last flush and wait until it is on the panel
+ *
+ * @param dev
+ */
+void lcdFlush(TFT_t *dev)
+{
+    lcd_cmd_t cmd = { .op = LCD_OP_FLUSH, .arg = { 1 } };
+    if (lcd_service_defer(dev, &cmd, true)) return;
+    lcdLock(dev);
+    lcdFlushAsync(dev);
+    spi_master_wait(dev);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Queue what changed in the framebuffer since the last flush and return. Drawing before
+ * lcdWaitDone() is allowed: a pixel changed while it is on the wire is dirty again and goes out
+ * with the next flush.
+ *
+ * @param dev
+ */
+void lcdFlushAsync(TFT_t *dev)
+{
+    lcd_cmd_t cmd = { .op = LCD_OP_FLUSH, .arg = { 0 } };
+    if (lcd_service_defer(dev, &cmd, false)) return;
+    lcdLock(dev);
+    if (dev->_fb != NULL) {
+        lcd_fb_flush(dev, dev->_fb);
+    }
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Width in pixels a string of ANK characters gets on the panel, as lcdDrawString() draws it
+ *
+ * @param dev
+ * @param fx
+ * @param x
+ * @param y
+ * @param length characters
+ * @param height font height, 0 when the font can not be opened
+ * @return uint16_t
+ */
+static uint16_t lcd_text_extent(TFT_t *dev, FontxFile *fx, uint16_t x, uint16_t y, size_t length, uint8_t *height)
+{
+    // Same font lookup as GetFontx()
+    uint8_t w = 0;
+    *height = 0;
+    for (int i = 0; i < 2; i++) {
+        if (OpenFontx(&fx[i]) && fx[i].is_ank) {
+            w = fx[i].w;
+            *height = fx[i].h;
+            break;
+        }
+    }
+    if (*height == 0) return 0;
+    if (y + *height > dev->_height - 1) return 0;
+
+    uint16_t width = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (x + width + w > dev->_width - 1) break;
+        width += w;
+    }
+    return width;
+}
+
+/**
+ * @brief Columns of a text line padded to width pixels that lie on the panel
+ *
+ * @param dev
+ * @param x
+ * @param width
+ * @return uint16_t
+ */
+static uint16_t lcd_pad_width(TFT_t *dev, uint16_t x, uint16_t width)
+{
+    if (x > dev->_width - 1) return 0;
+    return width < dev->_width - x ? width : dev->_width - x;
+}
+
+/**
+ * @brief Panel area a recorded call may change, coordinates that wrap below zero in the
+ * drawing code make it the whole panel
+ *
+ * @param dev
+ * @param cmd
+ * @return false when the call draws nothing
+ */
+static bool lcd_cmd_bbox(TFT_t *dev, lcd_cmd_t *cmd)
+{
+    const uint16_t *a = cmd->arg;
+    int x1 = 0, y1 = 0, x2 = -1, y2 = -1;
+    bool wraps = false;
+
+    switch (cmd->op) {
+    case LCD_OP_PIXEL:
+        x1 = x2 = a[0];
+        y1 = y2 = a[1];
+        break;
+    case LCD_OP_PIXELS:
+    case LCD_OP_PIXELS_DMA:
+    case LCD_OP_FILL_RECT:
+        if (a[2] == 0 || a[3] == 0) return false;
+        x1 = a[0];
+        y1 = a[1];
+        x2 = a[0] + a[2] - 1;
+        y2 = a[1] + a[3] - 1;
+        break;
+    case LCD_OP_LINE:
+        x1 = a[0] < a[2] ? a[0] : a[2];
+        x2 = a[0] < a[2] ? a[2] : a[0];
+        y1 = a[1] < a[3] ? a[1] : a[3];
+        y2 = a[1] < a[3] ? a[3] : a[1];
+        break;
+    case LCD_OP_CIRCLE:
+        // Single pixels, the ones that wrap are dropped
+        x1 = a[0] - a[2];
+        x2 = a[0] + a[2];
+        y1 = a[1] - a[2];
+        y2 = a[1] + a[2];
+        break;
+    case LCD_OP_FILL_CIRCLE:
+    case LCD_OP_ARC:
+        x1 = a[0] - a[2];
+        x2 = a[0] + a[2];
+        y1 = a[1] - a[2];
+        y2 = a[1] + a[2];
+        break;
+    case LCD_OP_ROUND_RECT:
+    case LCD_OP_FILL_ROUND_RECT:
+        x1 = a[0] < a[2] ? a[0] : a[2];
+        x2 = a[0] < a[2] ? a[2] : a[0];
+        y1 = a[1] < a[3] ? a[1] : a[3];
+        y2 = a[1] < a[3] ? a[3] : a[1];
+        break;
+    case LCD_OP_FILL_POLYGON:
+    case LCD_OP_POLYLINE: {
+        const lcd_point_t *points = cmd->ptr;
+        if (a[0] == 0) return false;
+        x1 = x2 = points[0].x;
+        y1 = y2 = points[0].y;
+        for (uint16_t i = 1; i < a[0]; i++) {
+            if (points[i].x < x1) x1 = points[i].x;
+            if (points[i].x > x2) x2 = points[i].x;
+            if (points[i].y < y1) y1 = points[i].y;
+            if (points[i].y > y2) y2 = points[i].y;
+        }
+        if (cmd->op == LCD_OP_POLYLINE) {
+            // Miter joins reach up to the width past a point, anti-aliased edges one more pixel
+            int margin = a[1] + 1;
+            x1 -= margin;
+            y1 -= margin;
+            x2 += margin;
+            y2 += margin;
+        }
+        break;
+    }
+    case LCD_OP_FILL_ARROW:
+        x1 = (a[0] < a[2] ? a[0] : a[2]) - a[4];
+        x2 = (a[0] < a[2] ? a[2] : a[0]) + a[4];
+        y1 = (a[1] < a[3] ? a[1] : a[3]) - a[4];
+        y2 = (a[1] < a[3] ? a[3] : a[1]) + a[4];
+        wraps = x1 < 0 || y1 < 0;
+        break;
+    case LCD_OP_CHAR:
+    case LCD_OP_CHAR_S:
+    case LCD_OP_STRING:
+    case LCD_OP_STRING_S: {
+        size_t length = cmd->op == LCD_OP_STRING || cmd->op == LCD_OP_STRING_S ? strlen(cmd->ptr) : 1;
+        uint8_t height;
+        uint16_t width = lcd_text_extent(dev, cmd->font, a[0], a[1], length, &height);
+        if (width == 0) return false;
+        x1 = a[0];
+        y1 = a[1];
+        x2 = a[0] + width - 1;
+        y2 = a[1] + height - 1;
+        break;
+    }
+    case LCD_OP_STRING_PAD: {
+        uint8_t height;
+        uint16_t width = lcd_text_extent(dev, cmd->font, a[0], a[1], strlen(cmd->ptr), &height);
+        uint16_t pad = lcd_pad_width(dev, a[0], a[4]);
+        if (height == 0 || a[1] + height > dev->_height - 1) return false;
+        if (width < pad) width = pad;
+        if (width == 0) return false;
+        x1 = a[0];
+        y1 = a[1];
+        x2 = a[0] + width - 1;
+        y2 = a[1] + height - 1;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if (wraps) {
+        x1 = 0;
+        y1 = 0;
+        x2 = dev->_width - 1;
+        y2 = dev->_height - 1;
+    }
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 > dev->_width - 1) x2 = dev->_width - 1;
+    if (y2 > dev->_height - 1) y2 = dev->_height - 1;
+    if (x1 > x2 || y1 > y2) return false;
+
+    cmd->bbox.x1 = x1;
+    cmd->bbox.y1 = y1;
+    cmd->bbox.x2 = x2;
+    cmd->bbox.y2 = y2;
+    return true;
+}
+
+/**
+ * @brief Run a recorded call
+ *
+ * @param dev
+ * @param cmd
+ */
+static void lcd_cmd_run(TFT_t *dev, const lcd_cmd_t *cmd)
+{
+    const uint16_t *a = cmd->arg;
+
+    switch (cmd->op) {
+    case LCD_OP_PIXEL:
+        lcdDrawPixel(dev, a[0], a[1], a[2]);
+        break;
+    case LCD_OP_PIXELS:
+        lcdDrawPixels(dev, a[0], a[1], a[2], a[3], (uint16_t *)cmd->ptr, a[4]);
+        break;
+    case LCD_OP_PIXELS_DMA:
+        lcdDrawPixelsDMA(dev, a[0], a[1], a[2], a[3], cmd->ptr, NULL, NULL);
+        break;
+    case LCD_OP_FILL_RECT:
+        lcdDrawFillRect(dev, a[0], a[1], a[2], a[3], a[4]);
+        break;
+    case LCD_OP_LINE:
+        lcdDrawLine(dev, a[0], a[1], a[2], a[3], a[4]);
+        break;
+    case LCD_OP_CIRCLE:
+        lcdDrawCircle(dev, a[0], a[1], a[2], a[3]);
+        break;
+    case LCD_OP_FILL_CIRCLE:
+        lcdDrawFillCircle(dev, a[0], a[1], a[2], a[3]);
+        break;
+    case LCD_OP_ROUND_RECT:
+        lcdDrawRoundRect(dev, a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+    case LCD_OP_FILL_ROUND_RECT:
+        lcdDrawFillRoundRect(dev, a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+    case LCD_OP_ARC:
+        lcdDrawArc(dev, a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+        break;
+    case LCD_OP_FILL_POLYGON:
+        lcdDrawFillPolygon(dev, cmd->ptr, a[0], a[1]);
+        break;
+    case LCD_OP_POLYLINE:
+        lcdDrawPolyline(dev, cmd->ptr, a[0], a[1], a[2], a[3]);
+        break;
+    case LCD_OP_FILL_ARROW:
+        lcdDrawFillArrow(dev, a[0], a[1], a[2], a[3], a[4], a[5]);
+        break;
+    case LCD_OP_CHAR:
+        lcdDrawChar(dev, cmd->font, a[0], a[1], a[2], a[3], a[4]);
+        break;
+    case LCD_OP_CHAR_S:
+        lcdDrawCharS(dev, cmd->font, a[0], a[1], a[2], a[3]);
+        break;
+    case LCD_OP_STRING:
+        lcdDrawString(dev, cmd->font, a[0], a[1], (char *)cmd->ptr, a[2], a[3]);
+        break;
+    case LCD_OP_STRING_S:
+        lcdDrawStringS(dev, cmd->font, a[0], a[1], (char *)cmd->ptr, a[2]);
+        break;
+    case LCD_OP_STRING_PAD:
+        lcdDrawStringPadded(dev, cmd->font, a[0], a[1], (char *)cmd->ptr, a[2], a[3], a[4]);
+        break;
+    case LCD_OP_FONT_DIRECTION:
+        lcdSetFontDirection(dev, a[0]);
+        break;
+    case LCD_OP_FONT_FILL:
+        if (a[0]) {
+            lcdSetFontFill(dev, a[1]);
+        } else {
+            lcdUnsetFontFill(dev);
+        }
+        break;
+    case LCD_OP_FONT_UNDERLINE:
+        if (a[0]) {
+            lcdSetFontUnderLine(dev, a[1]);
+        } else {
+            lcdUnsetFontUnderLine(dev);
+        }
+        break;
+    case LCD_OP_SCROLL:
+        lcdScrollTo(dev, a[0]);
+        break;
+    case LCD_OP_BEGIN_FRAME:
+        lcdBeginFrame(dev, a[0]);
+        break;
+    case LCD_OP_END_FRAME:
+        lcdEndFrame(dev);
+        break;
+    case LCD_OP_FLUSH:
+        if (a[0] == 2) {
+            lcdFlushSynced(dev);
+        } else if (a[0] == 1) {
+            lcdFlush(dev);
+        } else {
+            lcdFlushAsync(dev);
+        }
+        break;
+    case LCD_OP_PIXEL_BATCH: {
+        const lcd_batch_t *batch = cmd->ptr;
+        lcdDrawPixelBatch(dev, batch->points, batch->colors, a[0]);
+        break;
+    }
+    case LCD_OP_CALL:
+        cmd->doneCb(cmd->doneArg);
+        break;
+    case LCD_OP_FENCE:
+        if (a[0]) spi_master_wait(dev);
+        xSemaphoreGive((SemaphoreHandle_t)cmd->ptr);
+        break;
+    }
+}
+
+/**
+ * @brief Reserve room for a copy of call data, 4-byte aligned
+ *
+ * @param bands
+ * @param len
+ * @return void* NULL when the frame is out of data space
+ */
+static void *lcd_bands_alloc(lcd_bands_t *bands, size_t len)
+{
+    uint32_t start = (bands->dataUsed + 3) & ~3;
+    if (start + len > bands->dataLen) return NULL;
+    bands->dataUsed = start + len;
+    return bands->data + start;
+}
+
+/**
+ * @brief Replay the recorded calls band by band and send every band that changes. Ends the recording.
+ *
+ * @param dev
+ */
+static void lcd_bands_render(TFT_t *dev)
+{
+    lcd_bands_t *bands = dev->_bands;
+    lcd_framebuffer_t *target = dev->_fb;
+    *lcd_capture_hook(dev) = NULL;
+
+    int y1 = dev->_height;
+    int y2 = -1;
+    for (uint16_t i = 0; i < bands->cmdCount; i++) {
+        if (bands->cmds[i].bbox.y1 < y1) y1 = bands->cmds[i].bbox.y1;
+        if (bands->cmds[i].bbox.y2 > y2) y2 = bands->cmds[i].bbox.y2;
+    }
+    // Bands nothing is drawn in, now or in the last frame, already show the background
+    bool all = !bands->painted || bands->paintedBg != bands->bgColor;
+
+    uint8_t next = 0;
+    for (uint16_t y0 = 0; y0 < dev->_height; y0 += bands->bandHeight) {
+        uint16_t rows = dev->_height - y0 < bands->bandHeight ? dev->_height - y0 : bands->bandHeight;
+        int yEnd = y0 + rows - 1;
+        bool drawn = y1 <= yEnd && y2 >= y0;
+        bool stale = bands->paintedY1 <= yEnd && bands->paintedY2 >= y0;
+        if (!all && !drawn && !stale) continue;
+
+        lcd_framebuffer_t *band = &bands->band[next];
+        spi_master_wait_seq(dev, bands->bandSeq[next]);
+        band->y = y0;
+        band->height = rows;
+        lcd_fb_fill(band, 0, y0, dev->_width - 1, yEnd, bands->bgColor);
+
+        // Stripes hold screen rows, the scroll offset applies when they are sent
+        uint16_t scrollHeight = dev->_scroll_height;
+        dev->_scroll_height = 0;
+        dev->_fb = band;
+        for (uint16_t i = 0; i < bands->cmdCount; i++) {
+            lcd_cmd_t *cmd = &bands->cmds[i];
+            if (cmd->bbox.y1 <= yEnd && cmd->bbox.y2 >= y0) {
+                lcd_cmd_run(dev, cmd);
+            }
+        }
+        dev->_fb = target;
+        dev->_scroll_height = scrollHeight;
+
+        lcd_span_t spans[4];
+        uint8_t count = lcd_scroll_spans(dev, y0, yEnd, spans);
+        for (uint8_t i = 0; i < count; i++) {
+            const uint16_t *data = band->pixels + (size_t)(spans[i].y - y0) * dev->_width;
+            spi_master_set_window(dev, 0, spans[i].row, dev->_width - 1, spans[i].row + spans[i].rows - 1);
+            spi_master_window_advance(dev, (uint32_t)dev->_width * spans[i].rows);
+            spi_master_queue_long(dev, (const uint8_t *)data, (size_t)dev->_width * spans[i].rows * 2);
+        }
+        bands->bandSeq[next] = dev->_trans_queued;
+        next ^= 1;
+    }
+
+    // Buffers of lcdDrawPixelsDMA() were copied into the bands, the caller gets them back now
+    for (uint16_t i = 0; i < bands->cmdCount; i++) {
+        if (bands->cmds[i].doneCb != NULL) {
+            bands->cmds[i].doneCb(bands->cmds[i].doneArg);
+        }
+    }
+
+    bands->painted = true;
+    bands->paintedBg = bands->bgColor;
+    bands->paintedY1 = y1;
+    bands->paintedY2 = y2;
+    bands->cmdCount = 0;
+    bands->dataUsed = 0;
+}
+
+/**
+ * @brief Record a drawing call of the current frame
+ *
+ * @param dev
+ * @param cmd
+ * @return false when the call has to run now: the frame is out of room, so what is recorded
+ * is sent and the rest of the frame draws straight to the panel
+ */
+static bool lcd_bands_capture(void *dev, const lcd_cmd_t *cmd)
+{
+    TFT_t *_dev = dev;
+    lcd_bands_t *bands = _dev->_bands;
+
+    lcd_cmd_t rec = *cmd;
+    if (!lcd_cmd_bbox(_dev, &rec)) {
+        if (rec.doneCb != NULL) rec.doneCb(rec.doneArg);
+        return true;
+    }
+
+    bool full = bands->cmdCount == bands->cmdMax;
+    size_t len = lcd_cmd_data_len(&rec);
+    if (!full && len > 0) {
+        // The caller may reuse its buffer before the frame ends
+        void *copy = lcd_bands_alloc(bands, len);
+        if (copy != NULL) {
+            memcpy(copy, rec.ptr, len);
+            rec.ptr = copy;
+        } else {
+            full = true;
+        }
+    }
+    if (full) {
+        ESP_LOGW(TAG, "frame exceeds %d calls or %d data bytes, drawing the rest directly", bands->cmdMax, (int)bands->dataLen);
+        lcd_bands_render(_dev);
+        return false;
+    }
+
+    bands->cmds[bands->cmdCount++] = rec;
+    return true;
+}
+
+static void lcd_bands_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    uint32_t *a = call->arg;
+    call->ret = lcdSetBands(call->dev, a[0], a[1], a[2]);
+}
+
+/**
+ * @brief Set up band rendering: a frame between lcdBeginFrame() and lcdEndFrame() is recorded
+ * and then drawn into a small stripe buffer band after band, at the cost of two stripes of RAM.
+ *
+ * @param dev
+ * @param bandHeight rows of a stripe
+ * @param maxCommands drawing calls a frame can record
+ * @param dataBytes room for the text and lcdDrawPixels() colors of a frame
+ * @return esp_err_t ESP_ERR_NO_MEM when the buffers could not be allocated
+ */
+esp_err_t lcdSetBands(TFT_t *dev, uint16_t bandHeight, uint16_t maxCommands, uint32_t dataBytes)
+{
+    lcd_remote_call_t call = { .dev = dev, .arg = { bandHeight, maxCommands, dataBytes } };
+    if (lcd_service_run(dev, lcd_bands_call, &call)) return call.ret;
+
+    lcdUnsetBands(dev);
+    if (bandHeight == 0 || maxCommands == 0) return ESP_ERR_INVALID_ARG;
+    if (bandHeight > dev->_height) {
+        bandHeight = dev->_height;
+    }
+
+    lcd_bands_t *bands = calloc(1, sizeof(lcd_bands_t));
+    if (bands == NULL) return ESP_ERR_NO_MEM;
+
+    size_t bandLen = (size_t)dev->_width * bandHeight * 2;
+    bands->cmds = malloc(sizeof(lcd_cmd_t) * maxCommands);
+    bands->data = dataBytes > 0 ? malloc(dataBytes) : NULL;
+    for (int i = 0; i < 2; i++) {
+        lcd_framebuffer_t *band = &bands->band[i];
+        band->pixels = heap_caps_malloc(bandLen, MALLOC_CAP_DMA);
+        band->width = dev->_width;
+        band->height = bandHeight;
+        band->owned = true;
+    }
+    dev->_bands = bands;
+    if (bands->cmds == NULL || (dataBytes > 0 && bands->data == NULL) || bands->band[0].pixels == NULL || bands->band[1].pixels == NULL) {
+        ESP_LOGE(TAG, "no memory for %d-row bands", bandHeight);
+        lcdUnsetBands(dev);
+        return ESP_ERR_NO_MEM;
+    }
+
+    bands->bandHeight = bandHeight;
+    bands->cmdMax = maxCommands;
+    bands->dataLen = dataBytes;
+    bands->paintedY1 = 0;
+    bands->paintedY2 = -1;
+    return ESP_OK;
+}
+
+/**
+ * @brief Send a frame in progress and free the band renderer
+ *
+ * @param dev
+ */
+void lcdUnsetBands(TFT_t *dev)
+{
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdUnsetBands, dev)) return;
+    lcd_bands_t *bands = dev->_bands;
+    if (bands == NULL) return;
+
+    lcdEndFrame(dev);
+    spi_master_wait(dev);
+    for (int i = 0; i < 2; i++) {
+        heap_caps_free(bands->band[i].pixels);
+    }
+    free(bands->cmds);
+    free(bands->data);
+    free(bands);
+    dev->_bands = NULL;
+}
+
+/**
+ * @brief Start recording a frame. The frame replaces the whole screen: anything it does
+ * not draw shows bgColor once lcdEndFrame() is called.
+ *
+ * @param dev
+ * @param bgColor
+ */
+void lcdBeginFrame(TFT_t *dev, uint16_t bgColor)
+{
+    lcd_cmd_t cmd = { .op = LCD_OP_BEGIN_FRAME, .arg = { bgColor } };
+    if (lcd_service_defer(dev, &cmd, false)) return;
+
+    lcd_capture_t *hook = lcd_capture_hook(dev);
+    if (dev->_bands == NULL) return;
+    lcdLock(dev);
+    if (*hook == lcd_bands_capture) {
+        lcd_bands_render(dev);
+    }
+
+    dev->_bands->bgColor = bgColor;
+    dev->_bands->cmdCount = 0;
+    dev->_bands->dataUsed = 0;
+    *hook = lcd_bands_capture;
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Render the recorded frame band by band and queue it to the panel. While the
+ * next band is rendered the previous one is on the wire.
+ *
+ * @param dev
+ */
+void lcdEndFrame(TFT_t *dev)
+{
+    lcd_cmd_t cmd = { .op = LCD_OP_END_FRAME };
+    if (lcd_service_defer(dev, &cmd, false)) return;
+
+    lcdLock(dev);
+    if (dev->_bands != NULL && *lcd_capture_hook(dev) == lcd_bands_capture) {
+        lcd_bands_render(dev);
+    }
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Read the line the panel is refreshing with GDCAN
+ *
+ * @param dev
+ * @param line
+ * @return esp_err_t error of the read
+ */
+static esp_err_t lcd_read_scanline(TFT_t *dev, int *line)
+{
+    // A dummy byte comes before N[9:8] and N[7:0]
+    uint8_t rx[2];
+    esp_err_t ret = spi_master_read_command(dev, LCD_CMD_GDCAN, 8, rx, sizeof(rx));
+    if (ret != ESP_OK) return ret;
+    *line = ((rx[0] << 8) | rx[1]) & 0x3FF;
+    return ESP_OK;
+}
+
+/**
+ * @brief Line the panel is refreshing now
+ *
+ * @param dev
+ * @param line
+ * @param frameStart set to the esp_timer time the current refresh started
+ * @return esp_err_t error of the GDCAN read
+ */
+static esp_err_t lcd_sync_scanline(TFT_t *dev, int *line, int64_t *frameStart)
+{
+    uint32_t period = dev->_frame_us;
+
+    if (dev->_sync == LCD_SYNC_TE_PIN) {
+        // The ISR may update the 64-bit time while it is read
+        int64_t vsync;
+        uint32_t count;
+        do {
+            count = dev->_te_count;
+            vsync = dev->_te_time;
+        } while (count != dev->_te_count);
+
+        int64_t now = esp_timer_get_time();
+        int64_t since = (now - vsync) % period;
+        *frameStart = now - since;
+        *line = since * SCAN_LINES / period;
+        return ESP_OK;
+    }
+
+    esp_err_t ret = lcd_read_scanline(dev, line);
+    if (ret != ESP_OK) return ret;
+    *frameStart = esp_timer_get_time() - (int64_t)*line * period / SCAN_LINES;
+    return ESP_OK;
+}
+
+/**
+ * @brief Gate lines the refresh passes to show a screen rectangle. The refresh runs along panel
+ * memory rows, which are screen columns under MADCTL MV, and from the far end under MY.
+ *
+ * @param dev
+ * @param rect
+ * @param first set to the line the refresh reaches first
+ * @param last set to the line it reaches last
+ */
+static void lcd_sync_lines(TFT_t *dev, const lcd_rect_t *rect, uint16_t *first, uint16_t *last)
+{
+    bool mv = dev->_rotation & 1;
+    bool my = dev->_rotation == DIRECTION180 || dev->_rotation == DIRECTION270;
+    uint16_t row1 = mv ? rect->x1 + dev->_offsetx : rect->y1 + dev->_offsety;
+    uint16_t row2 = mv ? rect->x2 + dev->_offsetx : rect->y2 + dev->_offsety;
+    *first = my ? GRAM_LINES - 1 - row2 : row1;
+    *last = my ? GRAM_LINES - 1 - row1 : row2;
+}
+
+/**
+ * @brief Wait until the refresh has passed a line
+ *
+ * @param dev
+ * @param y gate line
+ * @param frameStart set to the esp_timer time the refresh started that passed the line
+ * @return esp_err_t error of the GDCAN read
+ */
+static esp_err_t lcd_sync_wait_past(TFT_t *dev, uint16_t y, int64_t *frameStart)
+{
+    for (;;) {
+        int line;
+        esp_err_t ret = lcd_sync_scanline(dev, &line, frameStart);
+        if (ret != ESP_OK) return ret;
+        if (line > y) return ESP_OK;
+
+        int64_t wait = *frameStart + (int64_t)(y + 1) * dev->_frame_us / SCAN_LINES - esp_timer_get_time();
+        TickType_t ticks = (wait - SYNC_SPIN_US) / 1000 / portTICK_PERIOD_MS;
+        if (wait > SYNC_SPIN_US && ticks > 0) {
+            vTaskDelay(ticks);
+        }
+    }
+}
+
+static void lcd_vsync_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    call->ret = lcdWaitVsync(call->dev, call->arg[0]);
+}
+
+/**
+ * @brief Wait for the panel to start its next refresh
+ *
+ * @param dev
+ * @param timeoutMs
+ * @return esp_err_t ESP_ERR_TIMEOUT when no refresh started in time,
+ * ESP_ERR_NOT_SUPPORTED without display_config_t.frameSync, or the error of the GDCAN read
+ */
+esp_err_t lcdWaitVsync(TFT_t *dev, uint32_t timeoutMs)
+{
+    if (dev->_sync == LCD_SYNC_TE_PIN) {
+        xSemaphoreTake(dev->_te_sem, 0);
+        return xSemaphoreTake(dev->_te_sem, pdMS_TO_TICKS(timeoutMs)) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+    }
+    if (dev->_sync != LCD_SYNC_SCANLINE) return ESP_ERR_NOT_SUPPORTED;
+    // GDCAN is read over the bus, which the service task owns while it runs
+    lcd_remote_call_t call = { .dev = dev, .arg = { timeoutMs } };
+    if (lcd_service_run(dev, lcd_vsync_call, &call)) return call.ret;
+
+    int64_t timeout = esp_timer_get_time() + (int64_t)timeoutMs * 1000;
+    int64_t frameStart;
+    int last, line;
+    lcdLock(dev);
+    esp_err_t ret = lcd_sync_scanline(dev, &last, &frameStart);
+    lcdUnlock(dev);
+    if (ret != ESP_OK) return ret;
+    while (esp_timer_get_time() < timeout) {
+        // Sleep through most of the refresh, then poll for the wrap to line 0
+        int64_t wait = frameStart + dev->_frame_us - esp_timer_get_time();
+        TickType_t ticks = (wait - SYNC_SPIN_US) / 1000 / portTICK_PERIOD_MS;
+        if (wait > SYNC_SPIN_US && ticks > 0) {
+            vTaskDelay(ticks);
+        }
+        lcdLock(dev);
+        ret = lcd_sync_scanline(dev, &line, &frameStart);
+        lcdUnlock(dev);
+        if (ret != ESP_OK) return ret;
+        if (line < last) return ESP_OK;
+        last = line;
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+static void lcd_scanline_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    call->ret = lcdGetScanline(call->dev);
+}
+
+/**
+ * @brief Gate line the panel is refreshing now, -1 without display_config_t.frameSync or
+ * when the GDCAN read fails
+ *
+ * @param dev
+ * @return int
+ */
+int lcdGetScanline(TFT_t *dev)
+{
+    if (dev->_sync == LCD_SYNC_NONE) return -1;
+    lcd_remote_call_t call = { .dev = dev };
+    if (lcd_service_run(dev, lcd_scanline_call, &call)) return call.ret;
+
+    int64_t frameStart;
+    int line;
+    lcdLock(dev);
+    esp_err_t ret = lcd_sync_scanline(dev, &line, &frameStart);
+    lcdUnlock(dev);
+    return ret == ESP_OK ? line : -1;
+}
+
+/**
+ * @brief Flush the framebuffer without tearing: every dirty region, top to bottom, is sent right
+ * after the refresh has passed it, so the panel shows it complete on the next refresh.
+ * Waits until the flush is on the panel. Without display_config_t.frameSync this is lcdFlush().
+ *
+ * @param dev
+ */
+void lcdFlushSynced(TFT_t *dev)
+{
+    lcd_cmd_t cmd = { .op = LCD_OP_FLUSH, .arg = { 2 } };
+    if (lcd_service_defer(dev, &cmd, true)) return;
+    lcd_framebuffer_t *fb = dev->_fb;
+    if (dev->_sync == LCD_SYNC_NONE || fb == NULL) {
+        lcdFlush(dev);
+        return;
+    }
+
+    lcdLock(dev);
+    // Earlier transfers must not delay the timed ones
+    spi_master_wait(dev);
+
+    lcd_frame_stats_t *stats = &dev->_frame_stats;
+    uint32_t period = dev->_frame_us;
+    int64_t now = esp_timer_get_time();
+    if (dev->_sync_time != 0) {
+        uint32_t passed = dev->_sync == LCD_SYNC_TE_PIN ? dev->_te_count - dev->_sync_vsyncs : (now - dev->_sync_time) / period;
+        if (passed > 1) {
+            stats->missedVsyncs += passed - 1;
+        }
+    }
+    dev->_sync_time = now;
+    dev->_sync_vsyncs = dev->_te_count;
+
+    // In the order the refresh passes them
+    uint16_t first, last;
+    for (uint8_t i = 1; i < fb->dirtyCount; i++) {
+        lcd_rect_t rect = fb->dirty[i];
+        uint16_t key;
+        lcd_sync_lines(dev, &rect, &key, &last);
+        uint8_t j = i;
+        for (; j > 0; j--) {
+            lcd_sync_lines(dev, &fb->dirty[j - 1], &first, &last);
+            if (first <= key) break;
+            fb->dirty[j] = fb->dirty[j - 1];
+        }
+        fb->dirty[j] = rect;
+    }
+
+    int64_t deadline = INT64_MAX;
+    bool synced = true;
+    for (uint8_t i = 0; i < fb->dirtyCount; i++) {
+        lcd_rect_t *rect = &fb->dirty[i];
+        lcd_sync_lines(dev, rect, &first, &last);
+        int64_t frameStart;
+        if (synced && lcd_sync_wait_past(dev, last, &frameStart) != ESP_OK) {
+            // The refresh cannot be followed, the rest goes out right away
+            ESP_LOGE(TAG, "scanline read failed, flushing without sync");
+            synced = false;
+        }
+        if (synced) {
+            // The next refresh reaches the top of the region one period after this one did
+            int64_t due = frameStart + period + (int64_t)first * period / SCAN_LINES;
+            if (due < deadline) {
+                deadline = due;
+            }
+        }
+        lcd_fb_send(dev, fb, rect);
+    }
+    fb->dirtyCount = 0;
+    spi_master_wait(dev);
+
+    if (deadline != INT64_MAX) {
+        int32_t slack = deadline - esp_timer_get_time();
+        stats->frames++;
+        stats->lastSlackUs = slack;
+        if (slack < stats->minSlackUs) {
+            stats->minSlackUs = slack;
+        }
+        if (slack < 0) {
+            stats->lateFrames++;
+        }
+    }
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Copy the frame pacing counters
+ *
+ * @param dev
+ * @param stats
+ */
+void lcdGetFrameStats(TFT_t *dev, lcd_frame_stats_t *stats)
+{
+    *stats = dev->_frame_stats;
+    stats->periodUs = dev->_frame_us;
+}
+
+/**
+ * @brief Clear the frame pacing counters
+ *
+ * @param dev
+ */
+void lcdResetFrameStats(TFT_t *dev)
+{
+    memset(&dev->_frame_stats, 0, sizeof(lcd_frame_stats_t));
+    dev->_frame_stats.minSlackUs = INT32_MAX;
+    dev->_sync_time = 0;
+}
+
+/**
+ * @brief Body of the service task: runs queued calls in order and sleeps while the queue is empty
+ *
+ * @param arg TFT_t
+ */
+static void lcd_service_task(void *arg)
+{
+    TFT_t *dev = arg;
+    struct lcd_service *svc = dev->_service;
+
+    for (;;) {
+        uint32_t pos = atomic_load_explicit(&svc->tail, memory_order_relaxed);
+        lcd_service_slot_t *slot = &svc->slots[pos & svc->mask];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1) {
+            // Idle: finish the transfers so their callbacks run, then wait for a push
+            spi_master_wait(dev);
+            atomic_store_explicit(&svc->sleeping, true, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            if (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            atomic_store_explicit(&svc->sleeping, false, memory_order_relaxed);
+            continue;
+        }
+
+        uint32_t depth = atomic_load_explicit(&svc->head, memory_order_relaxed) - pos;
+        if (depth > svc->maxDepth) svc->maxDepth = depth;
+
+        const lcd_cmd_t *cmd = &slot->cmd;
+        const uint16_t *a = cmd->arg;
+        if (cmd->op == LCD_OP_STOP) {
+            spi_master_wait(dev);
+            xSemaphoreGive((SemaphoreHandle_t)cmd->ptr);
+            vTaskDelete(NULL);
+        } else if (cmd->op == LCD_OP_PIXELS_DMA) {
+            // Band frames complete these calls themselves, lcd_cmd_run() leaves the callback out
+            lcdDrawPixelsDMA(dev, a[0], a[1], a[2], a[3], cmd->ptr, cmd->doneCb, cmd->doneArg);
+        } else {
+            lcd_cmd_run(dev, cmd);
+        }
+
+        atomic_store_explicit(&slot->seq, pos + svc->mask + 1, memory_order_release);
+        atomic_store_explicit(&svc->tail, pos + 1, memory_order_relaxed);
+        if (atomic_load_explicit(&svc->waiting, memory_order_relaxed) > 0) {
+            xSemaphoreGive(svc->space);
+        }
+    }
+}
+
+/**
+ * @brief Start a task that owns the panel. Drawing calls of other tasks only put a small
+ * command in a lock-free queue and return, the task runs them in order. lcdWaitDone() waits
+ * until everything queued before is on the panel, lcdFlush() also waits for its flush.
+ * Setup and read-back calls of other tasks (lcdSetFramebuffer(), lcdSetBands(),
+ * lcdSetScrollArea(), lcdSetOrientation(), lcdDisplayOn(), lcdReadRegion(), lcdGetScanline()
+ * and the like) run on the task and return once they are done.
+ *
+ * @param dev
+ * @param queueLen commands the queue holds, rounded up to a power of two. Callers wait while it is full.
+ * @param priority
+ * @param core core the task is pinned to, tskNO_AFFINITY for any
+ * @return esp_err_t ESP_ERR_NO_MEM when the queue or the task could not be created
+ */
+esp_err_t lcdStartService(TFT_t *dev, uint16_t queueLen, UBaseType_t priority, BaseType_t core)
+{
+    if (dev->_service != NULL) return ESP_ERR_INVALID_STATE;
+
+    uint32_t size = 2;
+    while (size < queueLen) size <<= 1;
+
+    struct lcd_service *svc = calloc(1, sizeof(struct lcd_service));
+    if (svc == NULL) return ESP_ERR_NO_MEM;
+    svc->slots = malloc(sizeof(lcd_service_slot_t) * size);
+    svc->space = xSemaphoreCreateBinary();
+    if (svc->slots == NULL || svc->space == NULL) {
+        ESP_LOGE(TAG, "no memory for a %d command queue", (int)size);
+        goto fail;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        atomic_init(&svc->slots[i].seq, i);
+    }
+    svc->mask = size - 1;
+    atomic_init(&svc->head, 0);
+    atomic_init(&svc->tail, 0);
+    atomic_init(&svc->waiting, 0);
+    atomic_init(&svc->sleeping, false);
+    atomic_init(&svc->stalls, 0);
+    atomic_init(&svc->inlineMiss, 0);
+    // A band frame in progress is continued by the task
+    svc->capture = dev->_capture;
+
+    dev->_service = svc;
+    if (xTaskCreatePinnedToCore(lcd_service_task, "lcd_service", SERVICE_STACK, dev, priority, &svc->task, core) != pdPASS) {
+        ESP_LOGE(TAG, "service task not created");
+        dev->_service = NULL;
+        goto fail;
+    }
+    dev->_capture = lcd_service_capture;
+    return ESP_OK;
+
+fail:
+    if (svc->space != NULL) vSemaphoreDelete(svc->space);
+    free(svc->slots);
+    free(svc);
+    return ESP_ERR_NO_MEM;
+}
+
+/**
+ * @brief Run what is queued, end the service task and draw on the calling task again.
+ * No other task may draw while this runs.
+ *
+ * @param dev
+ */
+void lcdStopService(TFT_t *dev)
+{
+    struct lcd_service *svc = dev->_service;
+    if (!lcd_service_remote(dev)) return;
+
+    StaticSemaphore_t buffer;
+    SemaphoreHandle_t done = xSemaphoreCreateBinaryStatic(&buffer);
+    lcd_cmd_t cmd = { .op = LCD_OP_STOP, .ptr = done };
+    lcd_service_send(dev, &cmd, NULL, 0);
+    xSemaphoreTake(done, portMAX_DELAY);
+    vSemaphoreDelete(done);
+
+    dev->_capture = svc->capture;
+    dev->_service = NULL;
+    vSemaphoreDelete(svc->space);
+    free(svc->slots);
+    free(svc);
+}
+
+/**
+ * @brief Run fn(arg) on the service task after the calls queued before it, or right away
+ * when no service task runs. Also a fence that does not block: fn runs once those calls are drawn.
+ *
+ * @param dev
+ * @param fn
+ * @param arg
+ */
+void lcdServiceCall(TFT_t *dev, lcd_done_cb_t fn, void *arg)
+{
+    lcd_cmd_t cmd = { .op = LCD_OP_CALL, .doneCb = fn, .doneArg = arg };
+    if (lcd_service_defer(dev, &cmd, false)) return;
+    fn(arg);
+}
+
+/**
+ * @brief Get the queue counters of the service task, all zero when none runs
+ *
+ * @param dev
+ * @param stats
+ */
+void lcdGetServiceStats(TFT_t *dev, lcd_service_stats_t *stats)
+{
+    memset(stats, 0, sizeof(lcd_service_stats_t));
+    struct lcd_service *svc = dev->_service;
+    if (svc == NULL) return;
+
+    uint32_t tail = atomic_load(&svc->tail);
+    uint32_t head = atomic_load(&svc->head);
+    stats->queued = head - svc->baseHead;
+    stats->executed = tail - svc->baseTail;
+    stats->depth = head - tail;
+    stats->maxDepth = svc->maxDepth;
+    stats->stalls = atomic_load(&svc->stalls);
+    stats->inlineMiss = atomic_load(&svc->inlineMiss);
+}
+
+/**
+ * @brief Reset the queue counters of the service task
+ *
+ * @param dev
+ */
+void lcdResetServiceStats(TFT_t *dev)
+{
+    struct lcd_service *svc = dev->_service;
+    if (svc == NULL) return;
+
+    svc->baseTail = atomic_load(&svc->tail);
+    svc->baseHead = atomic_load(&svc->head);
+    svc->maxDepth = 0;
+    atomic_store(&svc->stalls, 0);
+    atomic_store(&svc->inlineMiss, 0);
+}
+
+// Draw pixel
+// x:X coordinate
+// y:Y coordinate
 // color:color
-void lcdDrawPixel(TFT_t * dev, uint16_t x, uint16_t y, uint16_t color){
+static void lcd_draw_pixel(TFT_t * dev, uint16_t x, uint16_t y, uint16_t color){
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_PIXEL, .arg = { x, y, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
     if (x >= dev->_width) return;
     if (y >= dev->_height) return;
 
-    uint16_t _x = x + dev->_offsetx;
-    uint16_t _y = y + dev->_offsety;
+    lcd_span_t span;
+    lcd_scroll_spans(dev, y, y, &span);
 
-    spi_master_write_command(dev, 0x2A);	// set column(x) address
-    spi_master_write_addr(dev, _x, _x);
-    spi_master_write_command(dev, 0x2B);	// set Page(y) address
-    spi_master_write_addr(dev, _y, _y);
-    spi_master_write_command(dev, 0x2C);	//	Memory Write
-    spi_master_write_data_word(dev, color);
+    if (dev->_fb != NULL) {
+        lcd_fb_fill(dev->_fb, x, span.row, x, span.row, color);
+        return;
+    }
+
+    spi_master_set_window(dev, x, span.row, x, span.row);
+    spi_master_write_packet(dev, color, 1);
+}
+
+void lcdDrawPixel(TFT_t *dev, uint16_t x, uint16_t y, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_pixel(dev, x, y, color);
+    lcdUnlock(dev);
 }
 
 
@@ -327,8 +2780,12 @@ void lcdDrawPixel(TFT_t * dev, uint16_t x, uint16_t y, uint16_t color){
  * @param pixels
  * @param size
  */
-void lcdDrawPixels(TFT_t * dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *pixels, uint16_t size)
+static void lcd_draw_pixels(TFT_t * dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *pixels, uint16_t size)
 {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_PIXELS, .arg = { x, y, width, height, size }, .ptr = pixels };
+        if (dev->_capture(dev, &cmd)) return;
+    }
     if (width == 0) return;
     if (height == 0) return;
     if (x > dev->_width - 1) return;
@@ -346,55 +2803,388 @@ void lcdDrawPixels(TFT_t * dev, uint16_t x, uint16_t y, uint16_t width, uint16_t
         _y2 = dev->_height - 1;
     };
 
-    uint16_t _size = size <= width * height ? size : width * height;
+    uint32_t area = (uint32_t)(_x2 - _x1 + 1) * (_y2 - _y1 + 1);
+    uint32_t _size = size <= area ? size : area;
+    uint16_t cols = _x2 - _x1 + 1;
+
+    lcd_span_t spans[4];
+    uint8_t count = lcd_scroll_spans(dev, _y1, _y2, spans);
+    for (uint8_t i = 0; i < count; i++) {
+        uint32_t offset = (uint32_t)(spans[i].y - _y1) * cols;
+        if (offset >= _size) break;
+        uint32_t len = (uint32_t)spans[i].rows * cols;
+        if (len > _size - offset) {
+            len = _size - offset;
+        }
+        uint16_t row2 = spans[i].row + spans[i].rows - 1;
 
-    spi_master_write_command(dev, LCD_CMD_CASET);	// set column(x) address
-    spi_master_write_addr(dev, _x1, _x2);
-    spi_master_write_command(dev, LCD_CMD_RASET);	// set Page(y) address
-    spi_master_write_addr(dev, _y1, _y2);
-    spi_master_write_command(dev, LCD_CMD_RAMWR);	//	Memory Write
+        if (dev->_fb != NULL) {
+            lcd_fb_copy(dev->_fb, _x1, spans[i].row, _x2, row2, pixels + offset, len, cols, true);
+            continue;
+        }
+
+        spi_master_set_window(dev, _x1, spans[i].row, _x2, row2);
+
+        spi_master_write_colors(dev, pixels + offset, len);
+    }
+}
+
+void lcdDrawPixels(TFT_t *dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *pixels, uint16_t size)
+{
+    lcdLock(dev);
+    lcd_draw_pixels(dev, x, y, width, height, pixels, size);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Draw a region straight from a caller buffer without copying it. The buffer has to be
+ * DMA-capable, 32-bit aligned and hold big-endian RGB565 colors (see RGB565_BE), otherwise the
+ * SPI driver makes a temporary copy. The call returns once the transfer is queued.
+ *
+ * @param dev
+ * @param x
+ * @param y
+ * @param width
+ * @param height
+ * @param pixels width * height colors, must stay untouched until doneCb is called
+ * @param doneCb called from the task that reaps the last transaction (any later drawing call,
+ * lcdPollDone() or lcdWaitDone()), may be NULL
+ * @param arg passed to doneCb
+ */
+static void lcd_draw_pixels_dma(TFT_t *dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels, lcd_done_cb_t doneCb, void *arg)
+{
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_PIXELS_DMA, .arg = { x, y, width, height }, .ptr = pixels, .doneCb = doneCb, .doneArg = arg };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+    if (width == 0 || height == 0 || x > dev->_width - 1 || y > dev->_height - 1) {
+        if (doneCb != NULL) doneCb(arg);
+        return;
+    }
+
+    uint16_t _x1 = x;
+    uint16_t _x2 = x + width - 1;
+    uint16_t _y1 = y;
+    uint16_t _y2 = y + height - 1;
+
+    if (_x2 > dev->_width - 1) {
+        _x2 = dev->_width - 1;
+    }
+    if (_y2 > dev->_height - 1) {
+        _y2 = dev->_height - 1;
+    };
+
+    uint16_t cols = _x2 - _x1 + 1;
+
+    lcd_span_t spans[4];
+    uint8_t count = lcd_scroll_spans(dev, _y1, _y2, spans);
+    for (uint8_t i = 0; i < count; i++) {
+        const uint16_t *data = pixels + (size_t)(spans[i].y - _y1) * width;
+        uint16_t rows = spans[i].rows;
+        uint16_t row2 = spans[i].row + rows - 1;
+
+        if (dev->_fb != NULL) {
+            lcd_fb_copy(dev->_fb, _x1, spans[i].row, _x2, row2, data, UINT32_MAX, width, false);
+            continue;
+        }
+
+        spi_master_set_window(dev, _x1, spans[i].row, _x2, row2);
+        spi_master_window_advance(dev, (uint32_t)cols * rows);
+
+        if (cols == width) {
+            // Rows are contiguous, the whole region goes out in the fewest transactions
+            spi_master_queue_long(dev, (const uint8_t *)data, (size_t)cols * rows * 2);
+        } else {
+            // Clipped on the right, every row is sent from its own offset
+            for (uint16_t row = 0; row < rows; row++) {
+                spi_master_queue_data(dev, data + (size_t)row * width, cols * 2);
+            }
+        }
+    }
+
+    if (dev->_fb != NULL) {
+        if (doneCb != NULL) doneCb(arg);
+        return;
+    }
+
+    uint8_t slot = (dev->_trans_queued - 1) % LCD_TRANS_QUEUE_LEN;
+    dev->_trans_cb[slot] = doneCb;
+    dev->_trans_cb_arg[slot] = arg;
+}
+
+void lcdDrawPixelsDMA(TFT_t *dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels, lcd_done_cb_t doneCb, void *arg)
+{
+    lcdLock(dev);
+    lcd_draw_pixels_dma(dev, x, y, width, height, pixels, doneCb, arg);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Same as lcdDrawPixelsDMA(), but returns when the buffer can be reused
+ *
+ * @param dev
+ * @param x
+ * @param y
+ * @param width
+ * @param height
+ * @param pixels
+ */
+void lcdDrawPixelsDMAWait(TFT_t *dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels)
+{
+    lcdDrawPixelsDMA(dev, x, y, width, height, pixels, NULL, NULL);
+    lcdWaitDone(dev);
+}
+
+/**
+ * @brief Wait until everything queued to the panel is sent. Completion callbacks run from here.
+ *
+ * @param dev
+ */
+void lcdWaitDone(TFT_t *dev)
+{
+    if (lcd_service_remote(dev)) {
+        lcd_service_fence(dev, true);
+        return;
+    }
+    lcdLock(dev);
+    spi_master_wait(dev);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Run completion callbacks of transfers that are already finished, without blocking
+ *
+ * @param dev
+ */
+void lcdPollDone(TFT_t *dev)
+{
+    // The service task reaps its transfers itself
+    if (lcd_service_remote(dev)) return;
+    lcdLock(dev);
+    spi_master_poll(dev);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Draw a filled rectangle
+ *
+ * @param dev
+ * @param x1
+ * @param y1
+ * @param width
+ * @param height
+ * @param color
+ */
+static void lcd_draw_fill_rect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t width, uint16_t height, uint16_t color)
+{
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_FILL_RECT, .arg = { x1, y1, width, height, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+    if (width == 0) return;
+    if (height == 0) return;
+    if (x1 > dev->_width - 1) return;
+    if (y1 > dev->_height - 1) return;
+
+    uint16_t _x1 = x1;
+    uint16_t _x2 = x1 + width - 1;
+    uint16_t _y1 = y1;
+    uint16_t _y2 = y1 + height - 1;
+
+    if (_x2 > dev->_width - 1) {
+        _x2 = dev->_width - 1;
+    }
+    if (_y2 > dev->_height - 1) {
+        _y2 = dev->_height - 1;
+    };
+
+    lcd_span_t spans[4];
+    uint8_t count = lcd_scroll_spans(dev, _y1, _y2, spans);
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t row2 = spans[i].row + spans[i].rows - 1;
+
+        if (dev->_fb != NULL) {
+            lcd_fb_fill(dev->_fb, _x1, spans[i].row, _x2, row2, color);
+            continue;
+        }
+
+        uint32_t size = (uint32_t)(_x2 - _x1 + 1) * spans[i].rows;
+
+        spi_master_set_window(dev, _x1, spans[i].row, _x2, row2);
+
+        spi_master_write_packet(dev, color, size);
+    }
+}
+
+void lcdDrawFillRect(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t width, uint16_t height, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_fill_rect(dev, x1, y1, width, height, color);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Order of a point in a pixel batch: row by row, left to right
+ */
+static inline int32_t lcd_batch_key(const lcd_point_t *p)
+{
+    return (int32_t)p->y * 65536 + p->x;
+}
+
+/**
+ * @brief Reverse points first..last - 1 of a pixel batch with their colors
+ */
+static void lcd_batch_reverse(lcd_point_t *points, uint16_t *colors, uint32_t first, uint32_t last)
+{
+    while (first + 1 < last) {
+        last--;
+        lcd_point_t p = points[first]; points[first] = points[last]; points[last] = p;
+        uint16_t c = colors[first]; colors[first] = colors[last]; colors[last] = c;
+        first++;
+    }
+}
+
+/**
+ * @brief First point of first..last - 1 whose key is above key, or at least key when equal is set
+ */
+static uint32_t lcd_batch_bound(const lcd_point_t *points, uint32_t first, uint32_t last, int32_t key, bool equal)
+{
+    while (first < last) {
+        uint32_t mid = first + (last - first) / 2;
+        int32_t k = lcd_batch_key(&points[mid]);
+        if (k < key || (!equal && k == key)) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+/**
+ * @brief Merge the sorted runs first..middle - 1 and middle..last - 1 in place. Equal points
+ * of the first run stay before those of the second.
+ */
+static void lcd_batch_merge(lcd_point_t *points, uint16_t *colors, uint32_t first, uint32_t middle, uint32_t last)
+{
+    while (first < middle && middle < last) {
+        if (last - first == 2) {
+            if (lcd_batch_key(&points[middle]) < lcd_batch_key(&points[first])) {
+                lcd_batch_reverse(points, colors, first, last);
+            }
+            return;
+        }
+
+        // Split the longer run in half, find where its middle goes in the other one and
+        // rotate the parts between into place
+        uint32_t cut1, cut2;
+        if (middle - first > last - middle) {
+            cut1 = first + (middle - first) / 2;
+            cut2 = lcd_batch_bound(points, middle, last, lcd_batch_key(&points[cut1]), true);
+        } else {
+            cut2 = middle + (last - middle) / 2;
+            cut1 = lcd_batch_bound(points, first, middle, lcd_batch_key(&points[cut2]), false);
+        }
+        lcd_batch_reverse(points, colors, cut1, middle);
+        lcd_batch_reverse(points, colors, middle, cut2);
+        lcd_batch_reverse(points, colors, cut1, cut2);
+        uint32_t split = cut1 + (cut2 - middle);
+
+        // Recurse into the shorter side, loop on the longer one
+        if (split - first < last - split) {
+            lcd_batch_merge(points, colors, first, cut1, split);
+            first = split;
+            middle = cut2;
+        } else {
+            lcd_batch_merge(points, colors, split, cut2, last);
+            middle = cut1;
+            last = split;
+        }
+    }
+}
 
-    spi_master_write_colors(dev, pixels, _size);
+/**
+ * @brief Sort a pixel batch in place and stable, so that the last of a repeated point stays
+ * last: bottom-up merges by rotation, no scratch memory
+ */
+static void lcd_batch_sort(lcd_point_t *points, uint16_t *colors, uint16_t n)
+{
+    uint16_t i = 1;
+    while (i < n && lcd_batch_key(&points[i - 1]) <= lcd_batch_key(&points[i])) i++;
+    if (i >= n) return;
+
+    for (uint32_t width = 1; width < n; width *= 2) {
+        for (uint32_t first = 0; first + width < n; first += 2 * width) {
+            uint32_t last = first + 2 * width < n ? first + 2 * width : n;
+            lcd_batch_merge(points, colors, first, first + width, last);
+        }
+    }
 }
 
 /**
- * @brief Draw a filled rectangle
+ * @brief Draw scattered pixels with as few windows as possible. The points are sorted by row
+ * and column, neighbours on a row become one run, and runs that stack into a rectangle one block.
+ * A block of one color is a fill, any other one write of its colors.
  *
  * @param dev
- * @param x1
- * @param y1
- * @param width
- * @param height
- * @param color
+ * @param points reordered in place, points off the panel are skipped
+ * @param colors color of each point, reordered with them
+ * @param n
  */
-void lcdDrawFillRect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t width, uint16_t height, uint16_t color)
+static void lcd_draw_pixel_batch(TFT_t *dev, lcd_point_t *points, uint16_t *colors, uint16_t n)
 {
-    if (width == 0) return;
-    if (height == 0) return;
-    if (x1 > dev->_width - 1) return;
-    if (y1 > dev->_height - 1) return;
-
-    uint16_t _x1 = x1;
-    uint16_t _x2 = x1 + width - 1;
-    uint16_t _y1 = y1;
-    uint16_t _y2 = y1 + height - 1;
-
-    if (_x2 > dev->_width - 1) {
-        _x2 = dev->_width - 1;
+    lcd_batch_sort(points, colors, n);
+
+    // Drop the points off the panel and all but the last of a repeated point, so that the
+    // colors of each run are next to each other
+    uint16_t count = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        if (points[i].x < 0 || points[i].x >= dev->_width) continue;
+        if (points[i].y < 0 || points[i].y >= dev->_height) continue;
+        if (count > 0 && lcd_batch_key(&points[count - 1]) == lcd_batch_key(&points[i])) count--;
+        points[count] = points[i];
+        colors[count++] = colors[i];
     }
-    if (_y2 > dev->_height - 1) {
-        _y2 = dev->_height - 1;
-    };
 
-    uint16_t size = width * height;
+    for (uint16_t i = 0; i < count; ) {
+        // One run
+        uint16_t first = i;
+        for (i++; i < count && points[i].y == points[first].y && points[i].x == points[i - 1].x + 1; i++);
+        uint16_t width = i - first;
+
+        // Runs right below it that cover the same columns, when nothing else is between them
+        uint16_t height = 1;
+        while (i + width <= count
+            && points[i].y == points[first].y + height
+            && points[i].x == points[first].x
+            && points[i + width - 1].y == points[i].y
+            && points[i + width - 1].x == points[i].x + width - 1
+            && (i + width == count || points[i + width].y != points[i].y || points[i + width].x != points[i].x + width)) {
+            i += width;
+            height++;
+        }
 
-    spi_master_write_command(dev, LCD_CMD_CASET);	// set column(x) address
-    spi_master_write_addr(dev, _x1, _x2);
-    spi_master_write_command(dev, LCD_CMD_RASET);	// set Page(y) address
-    spi_master_write_addr(dev, _y1, _y2);
-    spi_master_write_command(dev, LCD_CMD_RAMWR);	//	Memory Write
+        uint16_t size = i - first;
+        uint16_t k = first + 1;
+        while (k < i && colors[k] == colors[first]) k++;
+        if (k == i) {
+            lcd_draw_fill_rect(dev, points[first].x, points[first].y, width, height, colors[first]);
+        } else {
+            lcd_draw_pixels(dev, points[first].x, points[first].y, width, height, colors + first, size);
+        }
+    }
+}
 
-    spi_master_write_packet(dev, color, size);
+void lcdDrawPixelBatch(TFT_t *dev, lcd_point_t *points, uint16_t *colors, uint16_t n)
+{
+    // One queue entry for the whole batch. The task sorts the arrays of the caller, which waits.
+    lcd_batch_t batch = { .points = points, .colors = colors };
+    lcd_cmd_t cmd = { .op = LCD_OP_PIXEL_BATCH, .arg = { n }, .ptr = &batch };
+    if (lcd_service_defer(dev, &cmd, true)) return;
+
+    lcdLock(dev);
+    lcd_draw_pixel_batch(dev, points, colors, n);
+    lcdUnlock(dev);
 }
 
 /**
@@ -408,7 +3198,7 @@ void lcdDrawFillRect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t width, uint
  * @param colors 
  * @param size 
  */
-uint16_t lcdReadRegion(TFT_t * dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *colors)
+static uint16_t lcd_read_region(TFT_t * dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *colors)
 {
     if (width == 0) return 0;
     if (height == 0) return 0;
@@ -429,15 +3219,28 @@ uint16_t lcdReadRegion(TFT_t * dev, uint16_t x, uint16_t y, uint16_t width, uint
 
     uint16_t colorsLen = width * height;
 
+    if (dev->_fb != NULL) {
+        // The framebuffer is what the panel shows after the next flush, read it instead
+        lcd_framebuffer_t *fb = dev->_fb;
+        uint16_t size = 0;
+        for (uint16_t y = _y1; y <= _y2; y++) {
+            for (uint16_t x = _x1; x <= _x2; x++) {
+                if (x < fb->x || x >= fb->x + fb->width || y < fb->y || y >= fb->y + fb->height) continue;
+                colors[size++] = RGB565_BE(fb->pixels[(size_t)(y - fb->y) * fb->width + (x - fb->x)]);
+            }
+        }
+        return size;
+    }
+
     ESP_LOGD("xy", "_x1:%d _x2:%d _y1:%d _y2:%d", _x1, _x2, _y1, _y2);
 
     spi_master_write_command(dev, LCD_CMD_COLMOD);  // Interface Pixel Format
     spi_master_write_data_byte(dev, 0x66);          // Needs by memory write (18bits color coding)
 
     spi_master_write_command(dev, LCD_CMD_CASET);	// set column(x) address
-    spi_master_write_addr(dev, _x1, _x2);
+    spi_master_write_addr(dev, _x1 + dev->_offsetx, _x2 + dev->_offsetx);
     spi_master_write_command(dev, LCD_CMD_RASET);	// set Page(y) address
-    spi_master_write_addr(dev, _y1, _y2);
+    spi_master_write_addr(dev, _y1 + dev->_offsety, _y2 + dev->_offsety);
 
     spi_master_write_command(dev, LCD_CMD_RAMRD);	//	Memory read
     uint16_t size = spi_master_read_packet(dev, colors, colorsLen);      // Read colors to buffer
@@ -448,14 +3251,38 @@ uint16_t lcdReadRegion(TFT_t * dev, uint16_t x, uint16_t y, uint16_t width, uint
     return size;
 }
 
+static void lcd_read_region_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    uint32_t *a = call->arg;
+    call->ret = lcdReadRegion(call->dev, a[0], a[1], a[2], a[3], call->ptr);
+}
+
+uint16_t lcdReadRegion(TFT_t *dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *colors)
+{
+    lcd_remote_call_t call = { .dev = dev, .arg = { x, y, width, height }, .ptr = colors };
+    if (lcd_service_run(dev, lcd_read_region_call, &call)) return call.ret;
+
+    lcdLock(dev);
+    uint16_t ret = lcd_read_region(dev, x, y, width, height, colors);
+    lcdUnlock(dev);
+    return ret;
+}
+
 // Display OFF
 void lcdDisplayOff(TFT_t * dev) {
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdDisplayOff, dev)) return;
+    lcdLock(dev);
     spi_master_write_command(dev, 0x28);	//Display off
+    lcdUnlock(dev);
 }
 
 // Display ON
 void lcdDisplayOn(TFT_t * dev) {
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdDisplayOn, dev)) return;
+    lcdLock(dev);
     spi_master_write_command(dev, 0x29);	//Display on
+    lcdUnlock(dev);
 }
 
 /**
@@ -533,49 +3360,82 @@ void lcdDrawVLineT(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t height, uint16
 }
 
 /**
- * @brief Draw line by coordinates
+ * @brief Span sink of a panel: fill x1,y1..x2,y2 as one window, parts off the panel are dropped
+ *
+ * @param dev TFT_t
+ * @param x1
+ * @param y1
+ * @param x2
+ * @param y2
+ * @param color
+ */
+static void lcd_span_fill(void *dev, int x1, int y1, int x2, int y2, uint16_t color)
+{
+    TFT_t *_dev = dev;
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= _dev->_width) x2 = _dev->_width - 1;
+    if (y2 >= _dev->_height) y2 = _dev->_height - 1;
+    if (x1 > x2 || y1 > y2) return;
+    lcd_draw_fill_rect(_dev, x1, y1, x2 - x1 + 1, y2 - y1 + 1, color);
+}
+
+/**
+ * @brief Fill row y from x1 to x2 as one window, parts off the panel are dropped
+ */
+static void lcd_draw_span(TFT_t *dev, int x1, int x2, int y, uint16_t color)
+{
+    lcd_span_fill(dev, x1, y, x2, y, color);
+}
+
+/**
+ * @brief Bresenham line, the same pixels as one lcdDrawPixel per step. Steps that keep the
+ * minor coordinate form a run, each run goes to the sink as one span.
  *
- * @param dev
  * @param x1 Start X coordinate
  * @param y1 Start Y coordinate
  * @param x2 End X coordinate
  * @param y2 End Y coordinate
- * @param color Line color
+ * @param color
+ * @param sink
+ * @param ctx passed to sink
  */
-void lcdDrawLine(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color) {
-    int i;
-    int dx,dy;
-    int sx,sy;
-    int E;
-
-    /* distance between two points */
-    dx = ( x2 > x1 ) ? x2 - x1 : x1 - x2;
-    dy = ( y2 > y1 ) ? y2 - y1 : y1 - y2;
-
-    /* direction of two point */
-    sx = ( x2 > x1 ) ? 1 : -1;
-    sy = ( y2 > y1 ) ? 1 : -1;
+void lcdLineSpans(int x1, int y1, int x2, int y2, uint16_t color, lcd_span_sink_t sink, void *ctx)
+{
+    /* distance and direction between two points */
+    int dx = ( x2 > x1 ) ? x2 - x1 : x1 - x2;
+    int dy = ( y2 > y1 ) ? y2 - y1 : y1 - y2;
+    int sx = ( x2 > x1 ) ? 1 : -1;
+    int sy = ( y2 > y1 ) ? 1 : -1;
 
     /* inclination < 1 */
     if ( dx > dy ) {
-        E = -dx;
-        for ( i = 0 ; i <= dx ; i++ ) {
-            lcdDrawPixel(dev, x1, y1, color);
-            x1 += sx;
+        int E = -dx;
+        int run = x1;
+        for ( int i = 0 ; i <= dx ; i++ ) {
             E += 2 * dy;
+            if ( E >= 0 || i == dx ) {
+                sink(ctx, sx > 0 ? run : x1, y1, sx > 0 ? x1 : run, y1, color);
+                run = x1 + sx;
+            }
+            x1 += sx;
             if ( E >= 0 ) {
-            y1 += sy;
-            E -= 2 * dx;
+                y1 += sy;
+                E -= 2 * dx;
+            }
         }
-    }
 
     /* inclination >= 1 */
     } else {
-        E = -dy;
-        for ( i = 0 ; i <= dy ; i++ ) {
-            lcdDrawPixel(dev, x1, y1, color);
-            y1 += sy;
+        int E = -dy;
+        int run = y1;
+        for ( int i = 0 ; i <= dy ; i++ ) {
             E += 2 * dx;
+            if ( E >= 0 || i == dy ) {
+                sink(ctx, x1, sy > 0 ? run : y1, x1, sy > 0 ? y1 : run, color);
+                run = y1 + sy;
+            }
+            y1 += sy;
             if ( E >= 0 ) {
                 x1 += sx;
                 E -= 2 * dy;
@@ -584,6 +3444,32 @@ void lcdDrawLine(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
     }
 }
 
+/**
+ * @brief Draw line by coordinates
+ *
+ * @param dev
+ * @param x1 Start X coordinate
+ * @param y1 Start Y coordinate
+ * @param x2 End X coordinate
+ * @param y2 End Y coordinate
+ * @param color Line color
+ */
+static void lcd_draw_line(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_LINE, .arg = { x1, y1, x2, y2, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+
+    lcdLineSpans(x1, y1, x2, y2, color, lcd_span_fill, dev);
+}
+
+void lcdDrawLine(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_line(dev, x1, y1, x2, y2, color);
+    lcdUnlock(dev);
+}
+
 /**
  * @brief Draw a rectangle primitive
  *
@@ -633,29 +3519,14 @@ void lcdDrawRectT(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t width, uint16_t
 // x1 = x * cos(angle) - y * sin(angle)
 // y1 = x * sin(angle) + y * cos(angle)
 void lcdDrawRectAngle(TFT_t * dev, uint16_t xc, uint16_t yc, uint16_t w, uint16_t h, uint16_t angle, uint16_t color) {
-    double xd,yd,rd;
-    int x1,y1;
-    int x2,y2;
-    int x3,y3;
-    int x4,y4;
-    rd = -angle * M_PI / 180.0;
-    xd = 0.0 - w/2;
-    yd = h/2;
-    x1 = (int)(xd * cos(rd) - yd * sin(rd) + xc);
-    y1 = (int)(xd * sin(rd) + yd * cos(rd) + yc);
-
-    yd = 0.0 - yd;
-    x2 = (int)(xd * cos(rd) - yd * sin(rd) + xc);
-    y2 = (int)(xd * sin(rd) + yd * cos(rd) + yc);
-
-    xd = w/2;
-    yd = h/2;
-    x3 = (int)(xd * cos(rd) - yd * sin(rd) + xc);
-    y3 = (int)(xd * sin(rd) + yd * cos(rd) + yc);
-
-    yd = 0.0 - yd;
-    x4 = (int)(xd * cos(rd) - yd * sin(rd) + xc);
-    y4 = (int)(xd * sin(rd) + yd * cos(rd) + yc);
+    int32_t x1,y1;
+    int32_t x2,y2;
+    int32_t x3,y3;
+    int32_t x4,y4;
+    geoRotate(-(w/2), h/2, angle, xc, yc, &x1, &y1);
+    geoRotate(-(w/2), -(h/2), angle, xc, yc, &x2, &y2);
+    geoRotate(w/2, h/2, angle, xc, yc, &x3, &y3);
+    geoRotate(w/2, -(h/2), angle, xc, yc, &x4, &y4);
 
     lcdDrawLine(dev, x1, y1, x2, y2, color);
     lcdDrawLine(dev, x1, y1, x3, y3, color);
@@ -675,52 +3546,161 @@ void lcdDrawRectAngle(TFT_t * dev, uint16_t xc, uint16_t yc, uint16_t w, uint16_
 // x1 = x * cos(angle) - y * sin(angle)
 // y1 = x * sin(angle) + y * cos(angle)
 void lcdDrawTriangle(TFT_t * dev, uint16_t xc, uint16_t yc, uint16_t w, uint16_t h, uint16_t angle, uint16_t color) {
-    double xd,yd,rd;
-    int x1,y1;
-    int x2,y2;
-    int x3,y3;
-    rd = -angle * M_PI / 180.0;
-    xd = 0.0;
-    yd = h/2;
-    x1 = (int)(xd * cos(rd) - yd * sin(rd) + xc);
-    y1 = (int)(xd * sin(rd) + yd * cos(rd) + yc);
-
-    xd = w/2;
-    yd = 0.0 - yd;
-    x2 = (int)(xd * cos(rd) - yd * sin(rd) + xc);
-    y2 = (int)(xd * sin(rd) + yd * cos(rd) + yc);
-
-    xd = 0.0 - w/2;
-    x3 = (int)(xd * cos(rd) - yd * sin(rd) + xc);
-    y3 = (int)(xd * sin(rd) + yd * cos(rd) + yc);
+    int32_t x1,y1;
+    int32_t x2,y2;
+    int32_t x3,y3;
+    geoRotate(0, h/2, angle, xc, yc, &x1, &y1);
+    geoRotate(w/2, -(h/2), angle, xc, yc, &x2, &y2);
+    geoRotate(-(w/2), -(h/2), angle, xc, yc, &x3, &y3);
 
     lcdDrawLine(dev, x1, y1, x2, y2, color);
     lcdDrawLine(dev, x1, y1, x3, y3, color);
     lcdDrawLine(dev, x2, y2, x3, y3, color);
 }
 
-// Draw circle
-// x0:Central X coordinate
-// y0:Central Y coordinate
-// r:radius
+// Draw filled triangle
+// xc:Center X coordinate
+// yc:Center Y coordinate
+// w:Width of triangle
+// h:Height of triangle
+// angle:Angle of triangle
 // color:color
-void lcdDrawCircle(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color) {
+void lcdDrawFillTriangle(TFT_t * dev, uint16_t xc, uint16_t yc, uint16_t w, uint16_t h, uint16_t angle, uint16_t color) {
+    int32_t x[3], y[3];
+    geoRotate(0, h/2, angle, xc, yc, &x[0], &y[0]);
+    geoRotate(w/2, -(h/2), angle, xc, yc, &x[1], &y[1]);
+    geoRotate(-(w/2), -(h/2), angle, xc, yc, &x[2], &y[2]);
+
+    lcd_point_t corners[3];
+    for (int i = 0; i < 3; i++) {
+        corners[i].x = x[i];
+        corners[i].y = y[i];
+    }
+    lcdDrawFillPolygon(dev, corners, 3, color);
+}
+
+/**
+ * @brief Midpoint circle walk, one row of a quadrant per lcd_circle_next()
+ */
+typedef struct {
     int x;
     int y;
     int err;
+    uint16_t r;
+} lcd_circle_t;
+
+static void lcd_circle_begin(lcd_circle_t *c, uint16_t r)
+{
+    c->x = 0;
+    c->y = -r;
+    c->err = 2 - 2 * r;
+    c->r = r;
+}
+
+/**
+ * @brief Next row of the circle, from the top (dy = r) down to the center row (dy = 0).
+ * The outline pixels of the row lie at offsets a1..a2 left and right of the center, the
+ * filled circle spans -a2..a2. Mirrored, the rows give the pixels lcdDrawCircle() and
+ * lcdDrawFillCircle() always set.
+ *
+ * @param c
+ * @param dy distance of the row from the center
+ * @param a1 innermost outline offset
+ * @param a2 outermost outline offset
+ * @return false after the center row
+ */
+static bool lcd_circle_next(lcd_circle_t *c, int *dy, int *a1, int *a2)
+{
     int old_err;
 
-    x=0;
-    y=-r;
-    err=2-2*r;
-    do{
-        lcdDrawPixel(dev, x0-x, y0+y, color);
-        lcdDrawPixel(dev, x0-y, y0-x, color);
-        lcdDrawPixel(dev, x0+x, y0-y, color);
-        lcdDrawPixel(dev, x0+y, y0+x, color);
-        if ((old_err=err)<=x)	err+=++x*2+1;
-        if (old_err>y || err>x) err+=++y*2+1;
-    } while(y<0);
+    if (c->y < 0) {
+        *dy = -c->y;
+        *a1 = c->x;
+        do {
+            *a2 = c->x;
+            if ((old_err=c->err)<=c->x) c->err+=++c->x*2+1;
+            if (old_err>c->y || c->err>c->x) c->err+=++c->y*2+1;
+        } while (c->y == -*dy);
+        return true;
+    }
+    if (c->y == 0) {
+        *dy = 0;
+        *a1 = c->r;
+        *a2 = c->r;
+        c->y = 1;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Outline of a circle as row spans, the pixels lcdDrawCircle() sets
+ *
+ * @param x0 Central X coordinate
+ * @param y0 Central Y coordinate
+ * @param r radius
+ * @param color
+ * @param sink
+ * @param ctx passed to sink
+ */
+void lcdCircleSpans(int x0, int y0, uint16_t r, uint16_t color, lcd_span_sink_t sink, void *ctx)
+{
+    lcd_circle_t c;
+    int dy, a1, a2;
+    lcd_circle_begin(&c, r);
+    while (lcd_circle_next(&c, &dy, &a1, &a2)) {
+        int rows[2] = { y0 - dy, y0 + dy };
+        for (int i = 0; i < (dy > 0 ? 2 : 1); i++) {
+            if (a1 == 0) {
+                sink(ctx, x0 - a2, rows[i], x0 + a2, rows[i], color);
+            } else {
+                sink(ctx, x0 - a2, rows[i], x0 - a1, rows[i], color);
+                sink(ctx, x0 + a1, rows[i], x0 + a2, rows[i], color);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Filled circle as one span per row, the pixels lcdDrawFillCircle() sets
+ *
+ * @param x0 Central X coordinate
+ * @param y0 Central Y coordinate
+ * @param r radius
+ * @param color
+ * @param sink
+ * @param ctx passed to sink
+ */
+void lcdFillCircleSpans(int x0, int y0, uint16_t r, uint16_t color, lcd_span_sink_t sink, void *ctx)
+{
+    lcd_circle_t c;
+    int dy, a1, a2;
+    lcd_circle_begin(&c, r);
+    while (lcd_circle_next(&c, &dy, &a1, &a2)) {
+        sink(ctx, x0 - a2, y0 - dy, x0 + a2, y0 - dy, color);
+        if (dy > 0) sink(ctx, x0 - a2, y0 + dy, x0 + a2, y0 + dy, color);
+    }
+}
+
+// Draw circle
+// x0:Central X coordinate
+// y0:Central Y coordinate
+// r:radius
+// color:color
+static void lcd_draw_circle(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_CIRCLE, .arg = { x0, y0, r, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+
+    lcdCircleSpans(x0, y0, r, color, lcd_span_fill, dev);
+}
+
+void lcdDrawCircle(TFT_t *dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_circle(dev, x0, y0, r, color);
+    lcdUnlock(dev);
 }
 
 // Draw circle of filling
@@ -728,26 +3708,20 @@ void lcdDrawCircle(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t c
 // y0:Central Y coordinate
 // r:radius
 // color:color
-void lcdDrawFillCircle(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color) {
-    int x;
-    int y;
-    int err;
-    int old_err;
-    int ChangeX;
-
-    x=0;
-    y=-r;
-    err=2-2*r;
-    ChangeX=1;
-    do{
-        if(ChangeX) {
-            lcdDrawLine(dev, x0-x, y0-y, x0-x, y0+y, color);
-            lcdDrawLine(dev, x0+x, y0-y, x0+x, y0+y, color);
-        } // endif
-        ChangeX=(old_err=err)<=x;
-        if (ChangeX)			err+=++x*2+1;
-        if (old_err>y || err>x) err+=++y*2+1;
-    } while(y<=0);
+static void lcd_draw_fill_circle(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_FILL_CIRCLE, .arg = { x0, y0, r, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+
+    lcdFillCircleSpans(x0, y0, r, color, lcd_span_fill, dev);
+}
+
+void lcdDrawFillCircle(TFT_t *dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_fill_circle(dev, x0, y0, r, color);
+    lcdUnlock(dev);
 }
 
 // Draw rectangle with round corner
@@ -757,12 +3731,13 @@ void lcdDrawFillCircle(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t r, uint16
 // y2:End	Y coordinate
 // r:radius
 // color:color
-void lcdDrawRoundRect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t r, uint16_t color) {
-    int x;
-    int y;
-    int err;
-    int old_err;
-    unsigned char temp;
+static void lcd_draw_round_rect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t r, uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_ROUND_RECT, .arg = { x1, y1, x2, y2, r, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+
+    uint16_t temp;
 
     if(x1>x2) {
         temp=x1; x1=x2; x2=temp;
@@ -777,27 +3752,345 @@ void lcdDrawRoundRect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16
     if (x2-x1 < r) return; // Add 20190517
     if (y2-y1 < r) return; // Add 20190517
 
-    x=0;
-    y=-r;
-    err=2-2*r;
-
-    do{
-        if(x) {
-            lcdDrawPixel(dev, x1+r-x, y1+r+y, color);
-            lcdDrawPixel(dev, x2-r+x, y1+r+y, color);
-            lcdDrawPixel(dev, x1+r-x, y2-r-y, color);
-            lcdDrawPixel(dev, x2-r+x, y2-r-y, color);
-        } // endif
-        if ((old_err=err)<=x)	err+=++x*2+1;
-        if (old_err>y || err>x) err+=++y*2+1;
-    } while(y<0);
-
-    ESP_LOGD(TAG, "x1+r=%d x2-r=%d",x1+r, x2-r);
-    lcdDrawLine(dev, x1+r,y1  ,x2-r,y1	,color);
-    lcdDrawLine(dev, x1+r,y2  ,x2-r,y2	,color);
-    ESP_LOGD(TAG, "y1+r=%d y2-r=%d",y1+r, y2-r);
-    lcdDrawLine(dev, x1  ,y1+r,x1  ,y2-r,color);
-    lcdDrawLine(dev, x2  ,y1+r,x2  ,y2-r,color);
+    // Corner rows; the top and bottom rows take the straight edges along
+    lcd_circle_t c;
+    int dy, a1, a2;
+    lcd_circle_begin(&c, r);
+    while (lcd_circle_next(&c, &dy, &a1, &a2)) {
+        int top = y1 + r - dy;
+        int bottom = y2 - r + dy;
+        if (dy == r) {
+            int left = x1 + r - a2 < x2 - r ? x1 + r - a2 : x2 - r;
+            int right = x2 - r + a2 > x1 + r ? x2 - r + a2 : x1 + r;
+            lcd_draw_span(dev, left, right, top, color);
+            lcd_draw_span(dev, left, right, bottom, color);
+        } else if (dy > 0) {
+            lcd_draw_span(dev, x1 + r - a2, x1 + r - a1, top, color);
+            lcd_draw_span(dev, x2 - r + a1, x2 - r + a2, top, color);
+            lcd_draw_span(dev, x1 + r - a2, x1 + r - a1, bottom, color);
+            lcd_draw_span(dev, x2 - r + a1, x2 - r + a2, bottom, color);
+        }
+    }
+
+    ESP_LOGD(TAG, "y1+r=%d y2-r=%d",y1+r, y2-r);
+    int edge1 = y1 + r < y2 - r ? y1 + r : y2 - r;
+    int edge2 = y1 + r < y2 - r ? y2 - r : y1 + r;
+    lcd_draw_fill_rect(dev, x1, edge1, 1, edge2 - edge1 + 1, color);
+    lcd_draw_fill_rect(dev, x2, edge1, 1, edge2 - edge1 + 1, color);
+}
+
+void lcdDrawRoundRect(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t r, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_round_rect(dev, x1, y1, x2, y2, r, color);
+    lcdUnlock(dev);
+}
+
+// Draw filled rectangle with round corner
+// x1:Start X coordinate
+// y1:Start Y coordinate
+// x2:End	X coordinate
+// y2:End	Y coordinate
+// r:radius
+// color:color
+static void lcd_draw_fill_round_rect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t r, uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_FILL_ROUND_RECT, .arg = { x1, y1, x2, y2, r, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+
+    uint16_t temp;
+
+    if(x1>x2) {
+        temp=x1; x1=x2; x2=temp;
+    } // endif
+
+    if(y1>y2) {
+        temp=y1; y1=y2; y2=temp;
+    } // endif
+
+    if (x2-x1 < r) return;
+    if (y2-y1 < r) return;
+
+    lcd_circle_t c;
+    int dy, a1, a2;
+    lcd_circle_begin(&c, r);
+    while (lcd_circle_next(&c, &dy, &a1, &a2)) {
+        if (dy == 0) break;
+        int left = x1 + r - a2 < x2 - r ? x1 + r - a2 : x2 - r;
+        int right = x2 - r + a2 > x1 + r ? x2 - r + a2 : x1 + r;
+        lcd_draw_span(dev, left, right, y1 + r - dy, color);
+        lcd_draw_span(dev, left, right, y2 - r + dy, color);
+    }
+    if (y2 - y1 >= 2 * r) {
+        lcd_draw_fill_rect(dev, x1, y1 + r, x2 - x1 + 1, y2 - y1 - 2 * r + 1, color);
+    }
+}
+
+void lcdDrawFillRoundRect(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t r, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_fill_round_rect(dev, x1, y1, x2, y2, r, color);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Fill the part of row y from x1 to x2 that lies in the arc sector, runs of pixels
+ * inside it are single windows
+ *
+ * @param dev
+ * @param x0 center
+ * @param y0 center
+ * @param x1 first offset from x0
+ * @param x2 last offset from x0
+ * @param dy row offset from y0
+ * @param dir start and end directions, Q16
+ * @param wide the sector is over 180 degrees
+ * @param color
+ */
+static void lcd_draw_arc_span(TFT_t *dev, int x0, int y0, int x1, int x2, int dy, const int64_t *dir, bool wide, uint16_t color)
+{
+    int run = x1;
+    for (int dx = x1; dx <= x2 + 1; dx++) {
+        bool inside = false;
+        if (dx <= x2) {
+            // Clockwise of the start and counterclockwise of the end direction
+            bool afterStart = dir[0] * dy - dir[1] * dx >= 0;
+            bool beforeEnd = dx * dir[3] - dy * dir[2] >= 0;
+            inside = wide ? (afterStart || beforeEnd) : (afterStart && beforeEnd);
+        }
+        if (!inside) {
+            if (run < dx) lcd_draw_span(dev, x0 + run, x0 + dx - 1, y0 + dy, color);
+            run = dx + 1;
+        }
+    }
+}
+
+// Draw arc of a ring
+// x0:Central X coordinate
+// y0:Central Y coordinate
+// r:Outer radius
+// thickness:Width of the ring, r or more fills the center
+// startAngle:Start in degrees, 0 at the top, clockwise
+// endAngle:End in degrees, startAngle + 360 for the whole ring
+// color:color
+static void lcd_draw_arc(TFT_t *dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t thickness, uint16_t startAngle, uint16_t endAngle, uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_ARC, .arg = { x0, y0, r, thickness, startAngle, endAngle, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+
+    if (thickness == 0) return;
+    bool whole = endAngle >= startAngle && endAngle - startAngle >= 360;
+    int sweep = ((int)endAngle - startAngle) % 360;
+    if (sweep < 0) sweep += 360;
+    if (!whole && sweep == 0) return;
+
+    // Directions of the ends, 0 degrees points up
+    int64_t dir[4];
+    dir[0] = geoSin(startAngle);
+    dir[1] = -geoCos(startAngle);
+    dir[2] = geoSin(endAngle);
+    dir[3] = -geoCos(endAngle);
+    bool wide = sweep > 180;
+
+    // The ring is the outer disc less the inner one, both walked row by row
+    lcd_circle_t outer, inner;
+    int dy, a1, a2;
+    int innerDy = -1, innerA2 = 0;
+    bool hole = thickness < r;
+    lcd_circle_begin(&outer, r);
+    if (hole) {
+        lcd_circle_begin(&inner, r - thickness);
+        lcd_circle_next(&inner, &innerDy, &a1, &innerA2);
+    }
+    while (lcd_circle_next(&outer, &dy, &a1, &a2)) {
+        int gap = -1;
+        if (hole && innerDy == dy) {
+            gap = innerA2;
+            if (!lcd_circle_next(&inner, &innerDy, &a1, &innerA2)) innerDy = -1;
+        }
+        for (int side = -1; side <= 1; side += 2) {
+            if (side > 0 && dy == 0) break;
+            int row = side * dy;
+            if (whole) {
+                if (gap < 0) {
+                    lcd_draw_span(dev, x0 - a2, x0 + a2, y0 + row, color);
+                } else {
+                    lcd_draw_span(dev, x0 - a2, x0 - gap - 1, y0 + row, color);
+                    lcd_draw_span(dev, x0 + gap + 1, x0 + a2, y0 + row, color);
+                }
+            } else if (gap < 0) {
+                lcd_draw_arc_span(dev, x0, y0, -a2, a2, row, dir, wide, color);
+            } else {
+                lcd_draw_arc_span(dev, x0, y0, -a2, -gap - 1, row, dir, wide, color);
+                lcd_draw_arc_span(dev, x0, y0, gap + 1, a2, row, dir, wide, color);
+            }
+        }
+    }
+}
+
+void lcdDrawArc(TFT_t *dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t thickness, uint16_t startAngle, uint16_t endAngle, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_arc(dev, x0, y0, r, thickness, startAngle, endAngle, color);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Polygon edge of the scanline filler, from its upper to its lower end
+ */
+typedef struct {
+    int16_t x1; ///< x of the upper end
+    int16_t y1; ///< First row
+    int16_t y2; ///< Last row
+    uint16_t dx; ///< Columns between the ends
+    int8_t sx;  ///< 1 when x grows downwards, else -1
+} lcd_edge_t;
+
+/**
+ * @brief Columns lcdDrawLine() sets on row y of the edge, drawn from its upper end
+ *
+ * @param e
+ * @param y row from e->y1 to e->y2
+ * @param lo leftmost column
+ * @param hi rightmost column
+ */
+static void lcd_edge_extent(const lcd_edge_t *e, int y, int *lo, int *hi)
+{
+    int64_t t = y - e->y1;
+    int64_t dy = e->y2 - e->y1;
+    int64_t dx = e->dx;
+    int first, last;
+    if (dy == 0) {
+        first = 0;
+        last = dx;
+    } else if (dx > dy) {
+        // Step i of the line lands on row (2 * dy * i + dx) / (2 * dx)
+        first = t == 0 ? 0 : ((2 * t - 1) * dx + 2 * dy - 1) / (2 * dy);
+        last = t == dy ? dx : ((2 * t + 1) * dx + 2 * dy - 1) / (2 * dy) - 1;
+    } else {
+        first = last = (2 * dx * t + dy) / (2 * dy);
+    }
+    if (e->sx > 0) {
+        *lo = e->x1 + first;
+        *hi = e->x1 + last;
+    } else {
+        *lo = e->x1 - last;
+        *hi = e->x1 - first;
+    }
+}
+
+// Draw filled polygon
+// points:Corners in order, edges join neighbours and the last to the first corner
+// count:Number of corners
+// color:color
+static void lcd_draw_fill_polygon(TFT_t *dev, const lcd_point_t *points, uint16_t count, uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_FILL_POLYGON, .arg = { count, color }, .ptr = points };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+
+    if (count == 0) return;
+    if (count > LCD_POLYGON_POINTS_MAX) {
+        ESP_LOGW(TAG, "polygon of %d corners, at most %d", count, LCD_POLYGON_POINTS_MAX);
+        return;
+    }
+
+    // Edge table sorted by the first row
+    lcd_edge_t edges[LCD_POLYGON_POINTS_MAX];
+    int ymin = points[0].y;
+    int ymax = points[0].y;
+    for (uint16_t i = 0; i < count; i++) {
+        const lcd_point_t *p = &points[i];
+        const lcd_point_t *q = &points[(i + 1) % count];
+        if (p->y < ymin) ymin = p->y;
+        if (p->y > ymax) ymax = p->y;
+        if (p->y > q->y || (p->y == q->y && p->x > q->x)) {
+            const lcd_point_t *t = p; p = q; q = t;
+        }
+        lcd_edge_t e;
+        e.x1 = p->x;
+        e.y1 = p->y;
+        e.y2 = q->y;
+        e.dx = q->x > p->x ? q->x - p->x : p->x - q->x;
+        e.sx = q->x >= p->x ? 1 : -1;
+        uint16_t j = i;
+        for (; j > 0 && edges[j - 1].y1 > e.y1; j--) edges[j] = edges[j - 1];
+        edges[j] = e;
+    }
+
+    // Active edge table, edges that reach the current row
+    uint8_t active[LCD_POLYGON_POINTS_MAX];
+    uint8_t activeCount = 0;
+    uint16_t next = 0;
+    int yEnd = ymax < dev->_height - 1 ? ymax : dev->_height - 1;
+    for (int y = ymin < 0 ? 0 : ymin; y <= yEnd; y++) {
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < activeCount; i++) {
+            if (y <= edges[active[i]].y2) active[kept++] = active[i];
+        }
+        activeCount = kept;
+        while (next < count && edges[next].y1 <= y) {
+            if (y <= edges[next].y2) active[activeCount++] = next;
+            next++;
+        }
+
+        // Edges that cross the row, ordered by x, bound the inside in even-odd pairs. An edge
+        // ends before its last row so that shared corners count once; on that row and on
+        // horizontal edges only its own pixels are filled.
+        int lo[LCD_POLYGON_POINTS_MAX], hi[LCD_POLYGON_POINTS_MAX];
+        int spanLo[LCD_POLYGON_POINTS_MAX * 2], spanHi[LCD_POLYGON_POINTS_MAX * 2];
+        uint8_t crossing = 0;
+        uint8_t spans = 0;
+        for (uint8_t i = 0; i < activeCount; i++) {
+            const lcd_edge_t *e = &edges[active[i]];
+            int l, h;
+            lcd_edge_extent(e, y, &l, &h);
+            if (y == e->y2) {
+                spanLo[spans] = l;
+                spanHi[spans++] = h;
+                continue;
+            }
+            uint8_t j = crossing++;
+            for (; j > 0 && lo[j - 1] + hi[j - 1] > l + h; j--) {
+                lo[j] = lo[j - 1];
+                hi[j] = hi[j - 1];
+            }
+            lo[j] = l;
+            hi[j] = h;
+        }
+        for (uint8_t i = 0; i + 1 < crossing; i += 2) {
+            spanLo[spans] = lo[i];
+            spanHi[spans++] = hi[i + 1];
+        }
+
+        // One window per run of overlapping spans
+        for (uint8_t i = 1; i < spans; i++) {
+            int l = spanLo[i], h = spanHi[i];
+            uint8_t j = i;
+            for (; j > 0 && spanLo[j - 1] > l; j--) {
+                spanLo[j] = spanLo[j - 1];
+                spanHi[j] = spanHi[j - 1];
+            }
+            spanLo[j] = l;
+            spanHi[j] = h;
+        }
+        for (uint8_t i = 0; i < spans; ) {
+            int l = spanLo[i], h = spanHi[i];
+            for (i++; i < spans && spanLo[i] <= h + 1; i++) {
+                if (spanHi[i] > h) h = spanHi[i];
+            }
+            lcd_draw_span(dev, l, h, y, color);
+        }
+    }
+}
+
+void lcdDrawFillPolygon(TFT_t *dev, const lcd_point_t *points, uint16_t count, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_fill_polygon(dev, points, count, color);
+    lcdUnlock(dev);
 }
 
 // Draw arrow
@@ -809,18 +4102,8 @@ void lcdDrawRoundRect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16
 // color:color
 // Thanks http://k-hiura.cocolog-nifty.com/blog/2010/11/post-2a62.html
 void lcdDrawArrow(TFT_t * dev, uint16_t x0,uint16_t y0,uint16_t x1,uint16_t y1,uint16_t w,uint16_t color) {
-    double Vx= x1 - x0;
-    double Vy= y1 - y0;
-    double v = sqrt(Vx*Vx+Vy*Vy);
-    //	 printf("v=%f\n",v);
-    double Ux= Vx/v;
-    double Uy= Vy/v;
-
-    uint16_t L[2],R[2];
-    L[0]= x1 - Uy*w - Ux*v;
-    L[1]= y1 + Ux*w - Uy*v;
-    R[0]= x1 + Uy*w - Ux*v;
-    R[1]= y1 - Ux*w - Uy*v;
+    int32_t L[2],R[2];
+    geoArrowBase(x0, y0, x1, y1, w, L, R);
     //printf("L=%d-%d R=%d-%d\n",L[0],L[1],R[0],R[1]);
 
     //lcdDrawLine(x0,y0,x1,y1,color);
@@ -837,38 +4120,216 @@ void lcdDrawArrow(TFT_t * dev, uint16_t x0,uint16_t y0,uint16_t x1,uint16_t y1,u
 // y2:End	Y coordinate
 // w:Width of the botom
 // color:color
-void lcdDrawFillArrow(TFT_t * dev, uint16_t x0,uint16_t y0,uint16_t x1,uint16_t y1,uint16_t w,uint16_t color) {
-    double Vx= x1 - x0;
-    double Vy= y1 - y0;
-    double v = sqrt(Vx*Vx+Vy*Vy);
-    //printf("v=%f\n",v);
-    double Ux= Vx/v;
-    double Uy= Vy/v;
-
-    uint16_t L[2],R[2];
-    L[0]= x1 - Uy*w - Ux*v;
-    L[1]= y1 + Ux*w - Uy*v;
-    R[0]= x1 + Uy*w - Ux*v;
-    R[1]= y1 - Ux*w - Uy*v;
-    //printf("L=%d-%d R=%d-%d\n",L[0],L[1],R[0],R[1]);
+static void lcd_draw_fill_arrow(TFT_t * dev, uint16_t x0,uint16_t y0,uint16_t x1,uint16_t y1,uint16_t w,uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_FILL_ARROW, .arg = { x0, y0, x1, y1, w, color } };
+        if (dev->_capture(dev, &cmd)) return;
+    }
 
-    lcdDrawLine(dev, x0, y0, x1, y1, color);
-    lcdDrawLine(dev, x1, y1, L[0], L[1], color);
-    lcdDrawLine(dev, x1, y1, R[0], R[1], color);
-    lcdDrawLine(dev, L[0], L[1], R[0], R[1], color);
+    int32_t L[2],R[2];
+    geoArrowBase(x0, y0, x1, y1, w, L, R);
+
+    // Tip and both corners of the base, the shaft from x0,y0 lies inside
+    lcd_point_t corners[3];
+    corners[0].x = x1;
+    corners[0].y = y1;
+    corners[1].x = L[0];
+    corners[1].y = L[1];
+    corners[2].x = R[0];
+    corners[2].y = R[1];
+
+    lcd_draw_fill_polygon(dev, corners, 3, color);
+}
+
+void lcdDrawFillArrow(TFT_t *dev, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t w, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_fill_arrow(dev, x0, y0, x1, y1, w, color);
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Mix color into a framebuffer pixel
+ *
+ * @param dev
+ * @param x
+ * @param y
+ * @param color
+ * @param alpha 0 keeps the pixel, 255 is color
+ */
+static void lcd_blend_pixel(TFT_t *dev, int x, int y, uint16_t color, uint8_t alpha)
+{
+    if (alpha == 0) return;
+    if (x < 0 || x >= dev->_width) return;
+    if (y < 0 || y >= dev->_height) return;
+
+    lcd_span_t span;
+    lcd_scroll_spans(dev, y, y, &span);
+    lcd_framebuffer_t *fb = dev->_fb;
+    if (x < fb->x || x >= fb->x + fb->width) return;
+    if (span.row < fb->y || span.row >= fb->y + fb->height) return;
+
+    uint16_t bg = RGB565_BE(fb->pixels[(size_t)(span.row - fb->y) * fb->width + (x - fb->x)]);
+    uint32_t a = alpha + (alpha >> 7);
+    uint32_t r = (((bg >> 11) & 0x1F) * (256 - a) + ((color >> 11) & 0x1F) * a) >> 8;
+    uint32_t g = (((bg >> 5) & 0x3F) * (256 - a) + ((color >> 5) & 0x3F) * a) >> 8;
+    uint32_t b = ((bg & 0x1F) * (256 - a) + (color & 0x1F) * a) >> 8;
+    lcd_fb_fill(fb, x, span.row, x, span.row, (r << 11) | (g << 5) | b);
+}
+
+// Draw anti-aliased line, Xiaolin Wu: each step covers two pixels across the line in
+// proportion to its distance from them. Only for a framebuffer, the pixels are mixed.
+// x1:Start X coordinate
+// y1:Start Y coordinate
+// x2:End X coordinate
+// y2:End Y coordinate
+// color:color
+static void lcd_draw_line_aa(TFT_t *dev, int x1, int y1, int x2, int y2, uint16_t color)
+{
+    bool steep = abs(y2 - y1) > abs(x2 - x1);
+    int t;
+    if (steep) {
+        t = x1; x1 = y1; y1 = t;
+        t = x2; x2 = y2; y2 = t;
+    }
+    if (x1 > x2) {
+        t = x1; x1 = x2; x2 = t;
+        t = y1; y1 = y2; y2 = t;
+    }
+
+    int dx = x2 - x1;
+    int32_t gradient = dx == 0 ? 0 : (int32_t)(((int64_t)(y2 - y1) * Q16_ONE) / dx);
+    int32_t y = y1 * Q16_ONE;
+    for (int x = x1; x <= x2; x++) {
+        int row = y >> 16;
+        uint8_t frac = (y & 0xFFFF) >> 8;
+        if (steep) {
+            lcd_blend_pixel(dev, row, x, color, 255 - frac);
+            lcd_blend_pixel(dev, row + 1, x, color, frac);
+        } else {
+            lcd_blend_pixel(dev, x, row, color, 255 - frac);
+            lcd_blend_pixel(dev, x, row + 1, color, frac);
+        }
+        y += gradient;
+    }
+}
+
+// Draw polyline
+// points:Points in order, each one joined to the next
+// count:Number of points
+// b:Width, thin lines for 0 and 1
+// style:LCD_JOIN_MITER or LCD_JOIN_ROUND, or'ed with LCD_LINE_AA
+// color:color
+static void lcd_draw_polyline(TFT_t *dev, const lcd_point_t *points, uint16_t count, uint16_t b, uint8_t style, uint16_t color) {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_POLYLINE, .arg = { count, b, style, color }, .ptr = points };
+        if (dev->_capture(dev, &cmd)) return;
+    }
+
+    // Mixing needs the pixels underneath, the panel itself is drawn solid
+    bool aa = (style & LCD_LINE_AA) && dev->_fb != NULL;
+
+    // Each side of a thick segment lies half the width minus the center pixel off the center
+    int64_t half = (int64_t)(b > 1 ? b - 1 : 0) * Q16_ONE / 2;
+    lcd_point_t prev = { 0, 0 };
+    q16_t pnx = 0, pny = 0;
+    bool joined = false;
+    for (uint16_t i = 1; i < count; i++) {
+        const lcd_point_t *p = &points[i - 1];
+        const lcd_point_t *q = &points[i];
+        int dx = q->x - p->x;
+        int dy = q->y - p->y;
+        if (dx == 0 && dy == 0) continue;
+
+        if (b <= 1) {
+            if (aa) {
+                lcd_draw_line_aa(dev, p->x, p->y, q->x, q->y, color);
+            } else if (p->x >= 0 && p->y >= 0 && q->x >= 0 && q->y >= 0) {
+                lcd_draw_line(dev, p->x, p->y, q->x, q->y, color);
+            } else {
+                // A two-corner polygon is the same line, clipped at the panel edge
+                lcd_point_t ends[2] = { *p, *q };
+                lcd_draw_fill_polygon(dev, ends, 2, color);
+            }
+            continue;
+        }
+
+        // The segment as a quad of span rows
+        q16_t nx, ny;
+        geoNormal(dx, dy, half, &nx, &ny);
+        lcd_point_t quad[4];
+        quad[0].x = geoRound((int64_t)p->x * Q16_ONE + nx);
+        quad[0].y = geoRound((int64_t)p->y * Q16_ONE + ny);
+        quad[1].x = geoRound((int64_t)q->x * Q16_ONE + nx);
+        quad[1].y = geoRound((int64_t)q->y * Q16_ONE + ny);
+        quad[2].x = geoRound((int64_t)q->x * Q16_ONE - nx);
+        quad[2].y = geoRound((int64_t)q->y * Q16_ONE - ny);
+        quad[3].x = geoRound((int64_t)p->x * Q16_ONE - nx);
+        quad[3].y = geoRound((int64_t)p->y * Q16_ONE - ny);
+        lcd_draw_fill_polygon(dev, quad, 4, color);
+        if (aa) {
+            lcd_draw_line_aa(dev, quad[0].x, quad[0].y, quad[1].x, quad[1].y, color);
+            lcd_draw_line_aa(dev, quad[3].x, quad[3].y, quad[2].x, quad[2].y, color);
+        }
 
-    int ww;
-    for(ww=w-1;ww>0;ww--) {
-        L[0]= x1 - Uy*ww - Ux*v;
-        L[1]= y1 + Ux*ww - Uy*v;
-        R[0]= x1 + Uy*ww - Ux*v;
-        R[1]= y1 - Ux*ww - Uy*v;
-        //printf("Fill>L=%d-%d R=%d-%d\n",L[0],L[1],R[0],R[1]);
-        lcdDrawLine(dev, x1, y1, L[0], L[1], color);
-        lcdDrawLine(dev, x1, y1, R[0], R[1], color);
+        // Fill the gap on the outer side of the turn at p
+        int64_t turn = (int64_t)(p->x - prev.x) * dy - (int64_t)(p->y - prev.y) * dx;
+        if (joined && turn != 0) {
+            if (style & LCD_JOIN_ROUND) {
+                if (p->x >= 0 && p->y >= 0) {
+                    lcd_draw_fill_circle(dev, p->x, p->y, (b - 1) / 2, color);
+                }
+            } else {
+                int64_t sign = turn > 0 ? -1 : 1;
+                int64_t ax = sign * pnx, ay = sign * pny;
+                int64_t bx = sign * nx, by = sign * ny;
+                int64_t px = (int64_t)p->x * Q16_ONE, py = (int64_t)p->y * Q16_ONE;
+                lcd_point_t wedge[4];
+                uint16_t corners = 0;
+                wedge[corners].x = p->x;
+                wedge[corners++].y = p->y;
+                wedge[corners].x = geoRound(px + ax);
+                wedge[corners++].y = geoRound(py + ay);
+                // The miter point lies on the bisector, w / cos(angle / 2) away. Past
+                // twice the width, a cosine of the normals below -1/2, it is cut off.
+                int64_t w2 = (half * half) >> 16;
+                int64_t dot = (ax * bx + ay * by) >> 16;
+                if (2 * dot + w2 > 0) {
+                    wedge[corners].x = geoRound(px + (ax + bx) * w2 / (w2 + dot));
+                    wedge[corners++].y = geoRound(py + (ay + by) * w2 / (w2 + dot));
+                }
+                wedge[corners].x = geoRound(px + bx);
+                wedge[corners++].y = geoRound(py + by);
+                lcd_draw_fill_polygon(dev, wedge, corners, color);
+            }
+        }
+        prev = *p;
+        pnx = nx;
+        pny = ny;
+        joined = true;
     }
 }
 
+void lcdDrawPolyline(TFT_t *dev, const lcd_point_t *points, uint16_t count, uint16_t b, uint8_t style, uint16_t color)
+{
+    lcdLock(dev);
+    lcd_draw_polyline(dev, points, count, b, style, color);
+    lcdUnlock(dev);
+}
+
+// Draw line of thickness b at any angle
+// x1:Start X coordinate
+// y1:Start Y coordinate
+// x2:End X coordinate
+// y2:End Y coordinate
+// b:Width
+// color:color
+void lcdDrawLineT(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t b, uint16_t color)
+{
+    lcd_point_t ends[2] = { { x1, y1 }, { x2, y2 } };
+    lcdDrawPolyline(dev, ends, 2, b, LCD_JOIN_MITER, color);
+}
+
 
 // RGB565 conversion
 // RGB565 is R(5)+G(6)+B(5)=16bit color format.
@@ -891,6 +4352,88 @@ uint16_t rgb24to16(uint32_t color)
     return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
 }
 
+/**
+ * @brief Expand a glyph bitmap into colors: set bits become fg, the others bg. Rows of the
+ * bitmap start on a byte.
+ *
+ * @param bits glyph from GetFontx()
+ * @param pw
+ * @param ph
+ * @param fg
+ * @param bg
+ * @param swapped store the colors big-endian, the way they go on the wire (RGB565_BE)
+ * @param dst first color of the glyph
+ * @param stride colors from one row of dst to the next
+ */
+void lcdExpandGlyph(const uint8_t *bits, uint8_t pw, uint8_t ph, uint16_t fg, uint16_t bg, bool swapped,
+                    uint16_t *dst, uint16_t stride)
+{
+    if (swapped) {
+        fg = RGB565_BE(fg);
+        bg = RGB565_BE(bg);
+    }
+    uint16_t rowBytes = (pw + 7) / 8;
+    for (uint8_t row = 0; row < ph; row++, bits += rowBytes, dst += stride) {
+        for (uint8_t col = 0; col < pw; col++) {
+            dst[col] = (bits[col / 8] & (0x80 >> (col % 8))) ? fg : bg;
+        }
+    }
+}
+
+/**
+ * @brief Find a glyph in the rendered glyph cache, or render it into the least recently used
+ * entry once that entry's transfers are finished
+ *
+ * @param dev
+ * @param fxs
+ * @param charCode
+ * @param color
+ * @param bgColor
+ * @return lcd_glyph_t* NULL when the cache is off, the font has no such glyph or it is too big
+ */
+static lcd_glyph_t *lcd_glyph_cache_get(TFT_t *dev, FontxFile *fxs, uint8_t charCode, uint16_t color, uint16_t bgColor)
+{
+    if (dev->_glyph_count == 0) return NULL;
+
+    lcd_glyph_t *glyph = NULL;
+    lcd_glyph_t *lru = &dev->_glyph_cache[0];
+    for (uint8_t i = 0; i < dev->_glyph_count; i++) {
+        lcd_glyph_t *g = &dev->_glyph_cache[i];
+        if (g->font == fxs && g->fontId[0] == fxs[0].id && g->fontId[1] == fxs[1].id &&
+            g->code == charCode && g->color == color && g->bgColor == bgColor) {
+            glyph = g;
+            break;
+        }
+        if (g->lastUse < lru->lastUse) {
+            lru = g;
+        }
+    }
+
+    if (glyph != NULL) {
+        dev->_glyph_stats.hits++;
+    } else {
+        uint8_t pw, ph;
+        if (!GetFontx(fxs, charCode, dev->_dots, &pw, &ph)) return NULL;
+        if (pw * ph > LCD_GLYPH_PIXELS) return NULL;
+        dev->_glyph_stats.misses++;
+
+        glyph = lru;
+        spi_master_wait_seq(dev, glyph->seq);
+        glyph->font = fxs;
+        glyph->fontId[0] = fxs[0].id;
+        glyph->fontId[1] = fxs[1].id;
+        glyph->code = charCode;
+        glyph->width = pw;
+        glyph->height = ph;
+        glyph->color = color;
+        glyph->bgColor = bgColor;
+
+        lcdExpandGlyph(dev->_dots, pw, ph, color, bgColor, true, glyph->pixels, pw);
+    }
+    glyph->lastUse = ++dev->_glyph_clock;
+    return glyph;
+}
+
 /**
  * @brief Fast draw char by code with a color and background color. Returns a char width in pixels.
  *
@@ -903,11 +4446,33 @@ uint16_t rgb24to16(uint32_t color)
  * @param bgColor
  * @return uint8_t
  */
-uint8_t lcdDrawChar(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t charCode, uint16_t color, uint16_t bgColor)
+static uint8_t lcd_draw_char(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t charCode, uint16_t color, uint16_t bgColor)
 {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_CHAR, .arg = { x, y, charCode, color, bgColor }, .font = fxs };
+        if (dev->_capture(dev, &cmd)) {
+            uint8_t ph;
+            return lcd_text_extent(dev, fxs, x, y, 1, &ph);
+        }
+    }
+
+    lcd_glyph_t *cached = lcd_glyph_cache_get(dev, fxs, charCode, color, bgColor);
+    if (cached != NULL) {
+        if (x + cached->width > dev->_width - 1) {
+            return 0;
+        }
+        if (y + cached->height > dev->_height - 1) {
+            return 0;
+        }
+        // Straight from the cache entry, which is not rewritten before this transfer is done
+        lcd_draw_pixels_dma(dev, x, y, cached->width, cached->height, cached->pixels, NULL, NULL);
+        cached->seq = dev->_trans_queued;
+        return cached->width;
+    }
+
     uint8_t pw, ph;
 
-    GetFontx(fxs, charCode, (uint8_t*) &dots, &pw, &ph);
+    GetFontx(fxs, charCode, dev->_dots, &pw, &ph);
 
     if (x + pw > dev->_width - 1) {
         return 0;
@@ -916,38 +4481,25 @@ uint8_t lcdDrawChar(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t
         return 0;
     }
 
-    uint16_t glyphIndex = 0;
-    uint16_t glyphBytes = ceil(pw / 8.0);
-    uint8_t lastBitsCount = pw % 8;
-    uint8_t lastBitNumber = lastBitsCount == 0 ? 0 : 8 - lastBitsCount;
-    uint8_t lastBitIndex = 0;
-    uint8_t bytesCounter = 0;
-    //ESP_LOGD("GetFontx", "rc=%d pw=%d ph=%d glyphBytes=%d lastBits=%d", rc, pw, ph, glyphBytes, lastBitsCount);
-
-    for (uint16_t i = 0; i < ph * glyphBytes; i++) {
-        // Find partial filled byte
-        bytesCounter++;
-        if (bytesCounter == glyphBytes) {
-            lastBitIndex = lastBitNumber;
-            bytesCounter = 0;
-        } else {
-            lastBitIndex = 0;
-        }
-
-        // Convert positive glyph bits to bytes and negative bits to background color
-        for (int8_t bitIndex = 7; bitIndex >= lastBitIndex; bitIndex--) {
-            glyph[glyphIndex] = ((dots[i] >> bitIndex) & 0x01) ? color : bgColor;
-            // TODO buffer overflow control
-            glyphIndex++;
-        }
+    // Send to display memory, which takes the colors in CPU order, in as many rows as _glyph holds
+    uint16_t rows = LCD_GLYPH_PIXELS / pw;
+    for (uint16_t row = 0; row < ph; row += rows) {
+        if (rows > ph - row) rows = ph - row;
+        lcdExpandGlyph(dev->_dots + row * ((pw + 7) / 8), pw, rows, color, bgColor, false, dev->_glyph, pw);
+        lcd_draw_pixels(dev, x, y + row, pw, rows, dev->_glyph, pw * rows);
     }
 
-    // Send to display memory
-    lcdDrawPixels(dev, x, y, pw, ph, (uint16_t*) &glyph, glyphIndex);
-
     return pw;
 }
 
+uint8_t lcdDrawChar(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t charCode, uint16_t color, uint16_t bgColor)
+{
+    lcdLock(dev);
+    uint8_t ret = lcd_draw_char(dev, fxs, x, y, charCode, color, bgColor);
+    lcdUnlock(dev);
+    return ret;
+}
+
 /**
  * @brief Slow draw char by code with a color. Returns a char width in pixels.
  * 
@@ -960,11 +4512,19 @@ uint8_t lcdDrawChar(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t
  * @param bgColor 
  * @return uint8_t 
  */
-uint8_t lcdDrawCharS(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t charCode, uint16_t color)
+static uint8_t lcd_draw_char_s(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t charCode, uint16_t color)
 {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_CHAR_S, .arg = { x, y, charCode, color }, .font = fxs };
+        if (dev->_capture(dev, &cmd)) {
+            uint8_t ph;
+            return lcd_text_extent(dev, fxs, x, y, 1, &ph);
+        }
+    }
+
     uint8_t pw, ph;
 
-    GetFontx(fxs, charCode, (uint8_t*) &dots, &pw, &ph);
+    GetFontx(fxs, charCode, dev->_dots, &pw, &ph);
 
     if (x + pw > dev->_width - 1) {
         return 0;
@@ -975,11 +4535,12 @@ uint8_t lcdDrawCharS(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t
 
     uint16_t dotX = x;
     uint16_t dotY = y;
-    uint16_t glyphBytes = ceil(pw / 8.0);
+    uint16_t glyphBytes = (pw + 7) / 8;
     uint8_t lastBitsCount = pw % 8;
     uint8_t lastBitNumber = lastBitsCount == 0 ? 0 : 8 - lastBitsCount;
     uint8_t lastBitIndex;
 	uint8_t bitsCounter = 0;
+    uint16_t dots = 0;
 
     for (uint16_t line = 0; line < ph * glyphBytes; line++) {
         // Find partial filled byte
@@ -989,11 +4550,18 @@ uint8_t lcdDrawCharS(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t
             lastBitIndex = lastBitNumber;
         }
 
-        // Drawing positive bits with pixels
+        // Collect positive bits as pixels
         for (int8_t bitIndex = 7; bitIndex >= lastBitIndex; bitIndex--) {
-            if ((dots[line] >> bitIndex) & 0x01) {
+            if ((dev->_dots[line] >> bitIndex) & 0x01) {
+                if (dots == LCD_GLYPH_PIXELS) {
+                    // Glyphs larger than the buffer go out in parts
+                    lcd_draw_pixel_batch(dev, dev->_glyphPoints, dev->_glyph, dots);
+                    dots = 0;
+                }
 				dotX = x + bitsCounter;
-                lcdDrawPixel(dev, dotX, dotY, color);
+                dev->_glyphPoints[dots].x = dotX;
+                dev->_glyphPoints[dots].y = dotY;
+                dev->_glyph[dots++] = color;
             }
             bitsCounter++;
         }
@@ -1005,11 +4573,136 @@ uint8_t lcdDrawCharS(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t
         }
     }
 
+    // Row by row already, each run of set bits goes out as one window
+    lcd_draw_pixel_batch(dev, dev->_glyphPoints, dev->_glyph, dots);
+
+    return pw;
+}
+
+uint8_t lcdDrawCharS(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t charCode, uint16_t color)
+{
+    lcdLock(dev);
+    uint8_t ret = lcd_draw_char_s(dev, fxs, x, y, charCode, color);
+    lcdUnlock(dev);
+    return ret;
+}
+
+// Completion of a text line, _strip may be rewritten
+static void lcd_strip_done(void *arg)
+{
+    TFT_t *dev = arg;
+    dev->_strip_busy = false;
+}
+
+/**
+ * @brief Get the text line buffer with room for len colors, once the last line is sent
+ *
+ * @param dev
+ * @param len
+ * @return uint16_t* NULL when it is out of memory or a band frame still holds the last line
+ */
+static uint16_t *lcd_strip_get(TFT_t *dev, uint32_t len)
+{
+    spi_master_wait_seq(dev, dev->_strip_seq);
+    if (dev->_strip_busy) return NULL;
+
+    if (dev->_strip_len < len) {
+        heap_caps_free(dev->_strip);
+        dev->_strip = heap_caps_malloc(len * 2, MALLOC_CAP_DMA);
+        dev->_strip_len = dev->_strip != NULL ? len : 0;
+    }
+    return dev->_strip;
+}
+
+/**
+ * @brief Render a glyph into the text line, from the rendered glyph cache when it holds it
+ *
+ * @param dev
+ * @param fxs
+ * @param charCode
+ * @param color
+ * @param bgColor
+ * @param dst first pixel of the glyph in the line
+ * @param stride pixels of a line row
+ * @param cols columns left in the line
+ * @param rows rows of the line
+ * @return uint8_t glyph width, 0 when the glyph does not fit the line
+ */
+static uint8_t lcd_strip_glyph(TFT_t *dev, FontxFile *fxs, uint8_t charCode, uint16_t color, uint16_t bgColor,
+                               uint16_t *dst, uint16_t stride, uint16_t cols, uint8_t rows)
+{
+    lcd_glyph_t *cached = lcd_glyph_cache_get(dev, fxs, charCode, color, bgColor);
+    if (cached != NULL) {
+        if (cached->width > cols || cached->height != rows) return 0;
+        for (uint8_t row = 0; row < rows; row++) {
+            memcpy(dst + (size_t)row * stride, cached->pixels + row * cached->width, cached->width * 2);
+        }
+        return cached->width;
+    }
+
+    uint8_t pw, ph;
+    if (!GetFontx(fxs, charCode, dev->_dots, &pw, &ph)) return 0;
+    if (pw > cols || ph != rows) return 0;
+
+    lcdExpandGlyph(dev->_dots, pw, ph, color, bgColor, true, dst, stride);
     return pw;
 }
 
 /**
- * @brief Fast draw a string with a color and background color. Returns a string length in pixels.
+ * @brief Lay out a string and its padding into the text line buffer and send it as one window
+ *
+ * @param dev
+ * @param fx
+ * @param x
+ * @param y
+ * @param str
+ * @param color
+ * @param bgColor
+ * @param width pixels from x to fill, 0 for the string only
+ * @param drawn set to the string width when the line was sent
+ * @return false when the caller has to draw the string glyph by glyph
+ */
+static bool lcd_draw_strip(TFT_t *dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor,
+                           uint16_t width, uint16_t *drawn)
+{
+    uint8_t rows;
+    uint16_t textWidth = lcd_text_extent(dev, fx, x, y, strlen(str), &rows);
+    *drawn = 0;
+    if (rows == 0 || y + rows > dev->_height - 1) return true;
+
+    uint16_t lineWidth = lcd_pad_width(dev, x, width);
+    if (lineWidth < textWidth) lineWidth = textWidth;
+    if (lineWidth == 0) return true;
+
+    uint16_t *line = lcd_strip_get(dev, (uint32_t)lineWidth * rows);
+    if (line == NULL) return false;
+
+    uint16_t col = 0;
+    for (size_t i = 0; col < textWidth; i++) {
+        uint8_t pw = lcd_strip_glyph(dev, fx, str[i], color, bgColor, line + col, lineWidth, textWidth - col, rows);
+        if (pw == 0) return false;
+        col += pw;
+    }
+
+    uint16_t bg = RGB565_BE(bgColor);
+    for (uint8_t row = 0; row < rows && col < lineWidth; row++) {
+        uint16_t *pad = line + (size_t)row * lineWidth;
+        for (uint16_t c = col; c < lineWidth; c++) {
+            pad[c] = bg;
+        }
+    }
+
+    // Held until the transfer, or the band frame that took it, is done
+    dev->_strip_busy = true;
+    lcd_draw_pixels_dma(dev, x, y, lineWidth, rows, line, lcd_strip_done, dev);
+    dev->_strip_seq = dev->_trans_queued;
+    *drawn = textWidth;
+    return true;
+}
+
+/**
+ * @brief Fast draw a string with a color and background color, padded with the background
+ * color up to width pixels. Returns a string length in pixels.
  *
  * @param dev
  * @param fx
@@ -1018,14 +4711,29 @@ uint8_t lcdDrawCharS(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t
  * @param str
  * @param color
  * @param bgColor
+ * @param width pixels from x to fill, 0 for the string only
  * @return uint16_t
  */
-uint16_t lcdDrawString(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor)
+static uint16_t lcd_draw_string(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor, uint16_t width)
 {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = width ? LCD_OP_STRING_PAD : LCD_OP_STRING, .arg = { x, y, color, bgColor, width }, .ptr = str, .font = fx };
+        if (dev->_capture(dev, &cmd)) {
+            uint8_t ph;
+            return lcd_text_extent(dev, fx, x, y, strlen(str), &ph);
+        }
+    }
+
+    uint16_t strWidth;
+    if (lcd_draw_strip(dev, fx, x, y, str, color, bgColor, width, &strWidth)) {
+        return strWidth;
+    }
+
+    // No line buffer: glyph by glyph, then the padding
     size_t length = strlen(str);
     uint16_t strX = x;
-    uint16_t strWidth = 0;
     uint16_t charWidth = 0;
+    strWidth = 0;
 
     for(size_t i = 0; i < length; i++) {
         charWidth = lcdDrawChar(dev, fx, strX + strWidth, y, str[i], color, bgColor);
@@ -1035,9 +4743,32 @@ uint16_t lcdDrawString(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char
         strWidth += charWidth;
     }
 
+    uint8_t ph;
+    uint16_t pad = lcd_pad_width(dev, x, width);
+    lcd_text_extent(dev, fx, x, y, 0, &ph);
+    if (pad > strWidth && ph != 0 && y + ph <= dev->_height - 1) {
+        lcdDrawFillRect(dev, x + strWidth, y, pad - strWidth, ph, bgColor);
+    }
+
     return strWidth;
 }
 
+uint16_t lcdDrawString(TFT_t *dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor)
+{
+    lcdLock(dev);
+    uint16_t ret = lcd_draw_string(dev, fx, x, y, str, color, bgColor, 0);
+    lcdUnlock(dev);
+    return ret;
+}
+
+uint16_t lcdDrawStringPadded(TFT_t *dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor, uint16_t width)
+{
+    lcdLock(dev);
+    uint16_t ret = lcd_draw_string(dev, fx, x, y, str, color, bgColor, width);
+    lcdUnlock(dev);
+    return ret;
+}
+
 /**
  * @brief Slow draw a string with a color without. Returns a string length in pixels.
  * 
@@ -1049,8 +4780,16 @@ uint16_t lcdDrawString(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char
  * @param color 
  * @return uint16_t 
  */
-uint16_t lcdDrawStringS(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color)
+static uint16_t lcd_draw_string_s(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color)
 {
+    if (dev->_capture != NULL) {
+        lcd_cmd_t cmd = { .op = LCD_OP_STRING_S, .arg = { x, y, color }, .ptr = str, .font = fx };
+        if (dev->_capture(dev, &cmd)) {
+            uint8_t ph;
+            return lcd_text_extent(dev, fx, x, y, strlen(str), &ph);
+        }
+    }
+
     size_t length = strlen(str);
     uint16_t strX = x;
     uint16_t strWidth = 0;
@@ -1067,33 +4806,51 @@ uint16_t lcdDrawStringS(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char
     return strWidth;
 }
 
+uint16_t lcdDrawStringS(TFT_t *dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color)
+{
+    lcdLock(dev);
+    uint16_t ret = lcd_draw_string_s(dev, fx, x, y, str, color);
+    lcdUnlock(dev);
+    return ret;
+}
+
 // Set font direction
 // dir:Direction
 void lcdSetFontDirection(TFT_t * dev, uint16_t dir) {
+    lcd_cmd_t cmd = { .op = LCD_OP_FONT_DIRECTION, .arg = { dir } };
+    if (lcd_service_defer(dev, &cmd, false)) return;
     dev->_font_direction = dir;
 }
 
 // Set font filling
 // color:fill color
 void lcdSetFontFill(TFT_t * dev, uint16_t color) {
+    lcd_cmd_t cmd = { .op = LCD_OP_FONT_FILL, .arg = { true, color } };
+    if (lcd_service_defer(dev, &cmd, false)) return;
     dev->_font_fill = true;
     dev->_font_fill_color = color;
 }
 
 // UnSet font filling
 void lcdUnsetFontFill(TFT_t * dev) {
+    lcd_cmd_t cmd = { .op = LCD_OP_FONT_FILL, .arg = { false } };
+    if (lcd_service_defer(dev, &cmd, false)) return;
     dev->_font_fill = false;
 }
 
 // Set font underline
 // color:frame color
 void lcdSetFontUnderLine(TFT_t * dev, uint16_t color) {
+    lcd_cmd_t cmd = { .op = LCD_OP_FONT_UNDERLINE, .arg = { true, color } };
+    if (lcd_service_defer(dev, &cmd, false)) return;
     dev->_font_underline = true;
     dev->_font_underline_color = color;
 }
 
 // UnSet font underline
 void lcdUnsetFontUnderLine(TFT_t * dev) {
+    lcd_cmd_t cmd = { .op = LCD_OP_FONT_UNDERLINE, .arg = { false } };
+    if (lcd_service_defer(dev, &cmd, false)) return;
     dev->_font_underline = false;
 }
 
@@ -1113,12 +4870,79 @@ void lcdBacklightOn(TFT_t * dev) {
 
 // Display Inversion Off
 void lcdInversionOff(TFT_t * dev) {
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdInversionOff, dev)) return;
+    lcdLock(dev);
     spi_master_write_command(dev, 0x20);	//Display Inversion Off
+    lcdUnlock(dev);
 }
 
 // Display Inversion On
 void lcdInversionOn(TFT_t * dev) {
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdInversionOn, dev)) return;
+    lcdLock(dev);
     spi_master_write_command(dev, 0x21);	//Display Inversion On
+    lcdUnlock(dev);
+}
+
+static void lcd_orientation_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    call->ret = lcdSetOrientation(call->dev, call->arg[0]);
+}
+
+/**
+ * @brief Rotate the image clockwise, for panels mounted turned. At 90 and 270 degrees width
+ * and height swap. Scrolling is turned off, lcdSetScrollArea() takes DIRECTION0 only;
+ * lcdFlushSynced() follows the refresh in every orientation.
+ *
+ * @param dev
+ * @param rotation DIRECTION0, DIRECTION90, DIRECTION180 or DIRECTION270
+ * @return esp_err_t ESP_ERR_INVALID_STATE when width and height would swap under a framebuffer or bands
+ */
+esp_err_t lcdSetOrientation(TFT_t *dev, uint8_t rotation)
+{
+    // MADCTL MY, MX and MV for each rotation
+    static const uint8_t madctl[4] = { 0x00, 0x60, 0xC0, 0xA0 };
+    if (rotation > DIRECTION270) return ESP_ERR_INVALID_ARG;
+    lcd_remote_call_t call = { .dev = dev, .arg = { rotation } };
+    if (lcd_service_run(dev, lcd_orientation_call, &call)) return call.ret;
+
+    bool swap = (rotation & 1) != (dev->_rotation & 1);
+    if (swap && (dev->_fb != NULL || dev->_bands != NULL)) return ESP_ERR_INVALID_STATE;
+
+    uint16_t width = (dev->_rotation & 1) ? dev->_height : dev->_width;
+    uint16_t height = (dev->_rotation & 1) ? dev->_width : dev->_height;
+
+    lcdLock(dev);
+    lcdSetScrollArea(dev, 0, 0);
+    spi_master_write_command(dev, LCD_CMD_MADCTL);
+    spi_master_write_data_byte(dev, madctl[rotation]);
+
+    // The image is anchored at the memory origin, mirrored axes move it to the far end
+    dev->_rotation = rotation;
+    dev->_width = (rotation & 1) ? height : width;
+    dev->_height = (rotation & 1) ? width : height;
+    dev->maxX = dev->_width - 1;
+    dev->maxY = dev->_height - 1;
+    dev->_offsetx = 0;
+    dev->_offsety = 0;
+    if (rotation == DIRECTION90) {
+        dev->_offsety = GRAM_COLUMNS - width;
+    } else if (rotation == DIRECTION180) {
+        dev->_offsetx = GRAM_COLUMNS - width;
+        dev->_offsety = GRAM_LINES - height;
+    } else if (rotation == DIRECTION270) {
+        dev->_offsetx = GRAM_LINES - height;
+    }
+    dev->_win_valid = false;
+    lcdUnlock(dev);
+    return ESP_OK;
+}
+
+static void lcd_read_madctl_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    call->ret = lcdReadMemoryDataAccessControl(call->dev, call->ptr);
 }
 
 /**
@@ -1130,24 +4954,18 @@ void lcdInversionOn(TFT_t * dev) {
  */
 esp_err_t lcdReadMemoryDataAccessControl(TFT_t *dev, mad_ctl_t *madCtl)
 {
-    spi_master_write_command(dev, LCD_CMD_RDD_MADCTL);
+    lcd_remote_call_t call = { .dev = dev, .ptr = madCtl };
+    if (lcd_service_run(dev, lcd_read_madctl_call, &call)) return call.ret;
 
-    gpio_set_level(dev->_dc, SPI_DATA_MODE);
-
-    spi_transaction_t SPITransaction;
-    memset(&SPITransaction, 0, sizeof(spi_transaction_t));
-    SPITransaction.flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_MODE_OCT;
-    SPITransaction.length = 8 * 1; // in bits
-    SPITransaction.rxlength = SPITransaction.length;
-
-    esp_err_t ret = spi_device_transmit( dev->_SPIHandle, &SPITransaction );
+    uint8_t madByte;
+    lcdLock(dev);
+    esp_err_t ret = spi_master_read_command(dev, LCD_CMD_RDD_MADCTL, 0, &madByte, 1);
+    lcdUnlock(dev);
 
     if (ret != ESP_OK) {
         return ret;
     }
 
-    uint8_t madByte = SPITransaction.rx_data[0];
-
     madCtl->MH  = madByte & 0x04;
     madCtl->RGB = madByte & 0x08;
     madCtl->ML  = madByte & 0x10;
@@ -1156,4 +4974,80 @@ esp_err_t lcdReadMemoryDataAccessControl(TFT_t *dev, mad_ctl_t *madCtl)
 	madCtl->MY  = madByte & 0x80;
 
     return ret;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Copy the address window cache counters
+ *
+ * @param dev
+ * @param stats
+ */
+static void lcd_window_stats_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    lcdGetWindowStats(call->dev, call->ptr);
+}
+
+void lcdGetWindowStats(TFT_t *dev, lcd_window_stats_t *stats)
+{
+    lcd_remote_call_t call = { .dev = dev, .ptr = stats };
+    if (lcd_service_run(dev, lcd_window_stats_call, &call)) return;
+    *stats = dev->_win_stats;
+}
+
+/**
+ * @brief Reset the address window cache counters
+ *
+ * @param dev
+ */
+void lcdResetWindowStats(TFT_t *dev)
+{
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdResetWindowStats, dev)) return;
+    memset(&dev->_win_stats, 0, sizeof(lcd_window_stats_t));
+}
+
+/**
+ * @brief Forget all rendered glyphs, e.g. to free the cache for other glyphs. A FontxFile
+ * added again with another font needs no call, its new FontxFile.id misses the old entries.
+ *
+ * @param dev
+ */
+void lcdClearGlyphCache(TFT_t *dev)
+{
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdClearGlyphCache, dev)) return;
+    lcdLock(dev);
+    for (uint8_t i = 0; i < dev->_glyph_count; i++) {
+        dev->_glyph_cache[i].font = NULL;
+    }
+    lcdUnlock(dev);
+}
+
+/**
+ * @brief Get the rendered glyph cache counters
+ *
+ * @param dev
+ * @param stats
+ */
+static void lcd_glyph_stats_call(void *arg)
+{
+    lcd_remote_call_t *call = arg;
+    lcdGetGlyphStats(call->dev, call->ptr);
+}
+
+void lcdGetGlyphStats(TFT_t *dev, lcd_glyph_stats_t *stats)
+{
+    lcd_remote_call_t call = { .dev = dev, .ptr = stats };
+    if (lcd_service_run(dev, lcd_glyph_stats_call, &call)) return;
+    *stats = dev->_glyph_stats;
+}
+
+/**
+ * @brief Reset the rendered glyph cache counters
+ *
+ * @param dev
+ */
+void lcdResetGlyphStats(TFT_t *dev)
+{
+    if (lcd_service_run(dev, (lcd_done_cb_t)lcdResetGlyphStats, dev)) return;
+    memset(&dev->_glyph_stats, 0, sizeof(lcd_glyph_stats_t));
+}
@@ -1,3 +1,7 @@
+#ifndef MAIN_ST7789_H_
+#define MAIN_ST7789_H_
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "driver/spi_master.h"
 #include "hal/gpio_types.h"
 #include "fontx.h"
@@ -7,6 +11,223 @@
 #define DIRECTION180	2
 #define DIRECTION270	3
 
+#define LCD_JOIN_MITER	0x00	// lcdDrawPolyline(): outer edges of thick segments meet in a point, bevelled past twice the width
+#define LCD_JOIN_ROUND	0x01	// lcdDrawPolyline(): thick segments meet in a filled circle
+#define LCD_LINE_AA		0x02	// lcdDrawPolyline(): Wu anti-aliased edges, needs a framebuffer or bands to blend with
+
+#define LCD_DMA_BUFF_MAX	8	// Upper limit of DMA buffers in the write ring, see display_config_t.bufferCount
+#define LCD_TRANS_QUEUE_LEN	16	// Transactions that may be queued at once, commands included
+#define LCD_FILL_CACHE_MAX	4	// Upper limit of cached fill patterns, see display_config_t.fillCacheSize
+#define LCD_DIRTY_RECTS_MAX	8	// Dirty rectangles a framebuffer tracks, more are merged into the closest one
+#define LCD_FONT_GLYPH_LEN	256	// Bytes of the largest font glyph bitmap
+#define LCD_GLYPH_PIXELS	512	// Colors of the largest glyph lcdDrawChar() draws
+#define LCD_POLYGON_POINTS_MAX	32	// Corners lcdDrawFillPolygon() takes
+#define LCD_GLYPH_CACHE_MAX	32	// Upper limit of rendered glyphs kept, see display_config_t.glyphCacheSize
+
+// Swaps RGB565 color bytes to the big-endian order the panel expects, for buffers passed to lcdDrawPixelsDMA()
+#define RGB565_BE(color)	((uint16_t)(((color) >> 8) | ((color) << 8)))
+
+/**
+ * @brief Called when the panel no longer needs a buffer passed to lcdDrawPixelsDMA()
+ */
+typedef void (*lcd_done_cb_t)(void *arg);
+
+/**
+ * @brief Takes one filled rectangle x1,y1..x2,y2 (inclusive) of lcdLineSpans() and friends.
+ * Coordinates are signed and may lie off any panel; the sink clips.
+ */
+typedef void (*lcd_span_sink_t)(void *ctx, int x1, int y1, int x2, int y2, uint16_t color);
+
+/**
+ * @brief D/C line level of a transaction, applied by the SPI pre-transfer callback
+ */
+typedef struct {
+	int16_t pin;
+	uint8_t level;
+} lcd_dc_t;
+
+/**
+ * @brief Address window cache counters
+ */
+typedef struct {
+	uint32_t hits;      ///< Column and row ranges were cached, only RAMWR or RAMWRC was sent
+	uint32_t continued; ///< Hits that continued the previous write with RAMWRC
+	uint32_t partial;   ///< Only one of CASET/RASET had to be sent
+	uint32_t misses;    ///< Full window setup
+} lcd_window_stats_t;
+
+/**
+ * @brief Rendered glyph cache counters
+ */
+typedef struct {
+	uint32_t hits;   ///< lcdDrawChar() sent a cached bitmap
+	uint32_t misses; ///< The glyph was read and rendered into the least recently used entry
+} lcd_glyph_stats_t;
+
+/**
+ * @brief How lcdFlushSynced() follows the panel refresh
+ */
+typedef enum {
+	LCD_SYNC_NONE,     ///< No synchronization, flushes start at once
+	LCD_SYNC_TE_PIN,   ///< Vsync interrupts from the TE output, the scanline is timed from them
+	LCD_SYNC_SCANLINE, ///< No TE wire, the scanline is polled with GDCAN
+} lcd_sync_t;
+
+/**
+ * @brief Frame pacing counters of lcdFlushSynced()
+ */
+typedef struct {
+	uint32_t frames;       ///< Synchronized flushes
+	uint32_t missedVsyncs; ///< Refreshes that passed without a flush between two flushes
+	uint32_t lateFrames;   ///< Flushes that ended after the scanline came back to them, they may have torn
+	int32_t lastSlackUs;   ///< Time from the end of the last flush to its deadline, negative when late
+	int32_t minSlackUs;    ///< Smallest slack seen
+	uint32_t periodUs;     ///< Refresh period in use
+} lcd_frame_stats_t;
+
+/**
+ * @brief Pre-patterned DMA buffer of one fill color
+ */
+typedef struct {
+	uint8_t *buff;    ///< Color bytes repeated, DMA-capable, diplayBufferLen bytes
+	uint32_t len;     ///< Bytes of the pattern written so far
+	uint32_t seq;     ///< _trans_done value at which the last transfer from buff is finished
+	uint32_t lastUse; ///< LRU stamp
+	uint16_t color;
+} lcd_fill_t;
+
+/**
+ * @brief Glyph rendered in two colors, ready to be sent as is
+ */
+typedef struct {
+	uint16_t *pixels;       ///< Big-endian RGB565 colors, DMA-capable, LCD_GLYPH_PIXELS of them
+	const FontxFile *font;  ///< NULL for an unused entry
+	uint32_t fontId[2];     ///< FontxFile.id of both fonts, a font added again is another font
+	uint8_t code;
+	uint8_t width;
+	uint8_t height;
+	uint16_t color;
+	uint16_t bgColor;
+	uint32_t seq;           ///< _trans_done value at which the last transfer from pixels is finished
+	uint32_t lastUse;       ///< LRU stamp
+} lcd_glyph_t;
+
+/**
+ * @brief Rectangle in panel coordinates, both corners inclusive
+ */
+typedef struct {
+	uint16_t x1;
+	uint16_t y1;
+	uint16_t x2;
+	uint16_t y2;
+} lcd_rect_t;
+
+/**
+ * @brief Corner of a polygon, may lie off the panel
+ */
+typedef struct {
+	int16_t x;
+	int16_t y;
+} lcd_point_t;
+
+/**
+ * @brief RAM render target. Drawing calls store into it and lcdFlush() sends the dirty parts.
+ */
+typedef struct {
+	uint16_t *pixels;   ///< Big-endian RGB565 colors, width * height, row by row
+	uint16_t x;         ///< Panel column of the first pixel
+	uint16_t y;         ///< Panel row of the first pixel
+	uint16_t width;
+	uint16_t height;
+	bool owned;         ///< pixels was allocated by the driver and is freed with the framebuffer
+	bool tracked;       ///< Changed regions are kept in dirty, bands are always sent whole
+	lcd_rect_t dirty[LCD_DIRTY_RECTS_MAX]; ///< Regions changed since the last flush
+	uint8_t dirtyCount;
+} lcd_framebuffer_t;
+
+/**
+ * @brief Calls that can be recorded as a lcd_cmd_t. Band frames record the drawing calls,
+ * the service task of lcdStartService() takes all of them.
+ */
+typedef enum {
+	LCD_OP_PIXEL,       ///< lcdDrawPixel(x, y, color)
+	LCD_OP_PIXELS,      ///< lcdDrawPixels(x, y, width, height, size), ptr holds the colors
+	LCD_OP_PIXELS_DMA,  ///< lcdDrawPixelsDMA(x, y, width, height), ptr holds the colors
+	LCD_OP_FILL_RECT,   ///< lcdDrawFillRect(x, y, width, height, color)
+	LCD_OP_LINE,        ///< lcdDrawLine(x1, y1, x2, y2, color)
+	LCD_OP_CIRCLE,      ///< lcdDrawCircle(x0, y0, r, color)
+	LCD_OP_FILL_CIRCLE, ///< lcdDrawFillCircle(x0, y0, r, color)
+	LCD_OP_ROUND_RECT,  ///< lcdDrawRoundRect(x1, y1, x2, y2, r, color)
+	LCD_OP_FILL_ROUND_RECT, ///< lcdDrawFillRoundRect(x1, y1, x2, y2, r, color)
+	LCD_OP_ARC,         ///< lcdDrawArc(x0, y0, r, thickness, startAngle, endAngle, color)
+	LCD_OP_FILL_ARROW,  ///< lcdDrawFillArrow(x0, y0, x1, y1, w, color)
+	LCD_OP_FILL_POLYGON, ///< lcdDrawFillPolygon(count, color), ptr holds the corners
+	LCD_OP_POLYLINE,    ///< lcdDrawPolyline(count, b, style, color), ptr holds the points
+	LCD_OP_CHAR,        ///< lcdDrawChar(x, y, charCode, color, bgColor)
+	LCD_OP_CHAR_S,      ///< lcdDrawCharS(x, y, charCode, color)
+	LCD_OP_STRING,      ///< lcdDrawString(x, y, color, bgColor), ptr holds the text
+	LCD_OP_STRING_S,    ///< lcdDrawStringS(x, y, color), ptr holds the text
+	LCD_OP_STRING_PAD,  ///< lcdDrawStringPadded(x, y, color, bgColor, width), ptr holds the text
+	LCD_OP_FONT_DIRECTION, ///< lcdSetFontDirection(dir)
+	LCD_OP_FONT_FILL,   ///< lcdSetFontFill(color) when on, else lcdUnsetFontFill(): (on, color)
+	LCD_OP_FONT_UNDERLINE, ///< lcdSetFontUnderLine(color) when on, else lcdUnsetFontUnderLine(): (on, color)
+	LCD_OP_SCROLL,      ///< lcdScrollTo(line)
+	LCD_OP_BEGIN_FRAME, ///< lcdBeginFrame(bgColor)
+	LCD_OP_END_FRAME,   ///< lcdEndFrame()
+	LCD_OP_FLUSH,       ///< lcdFlushAsync(), lcdFlush() or lcdFlushSynced(): (0, 1 or 2)
+	LCD_OP_PIXEL_BATCH, ///< lcdDrawPixelBatch(n) of another task, only queued to the service task: ptr holds the arrays
+	LCD_OP_CALL,        ///< lcdServiceCall(), doneCb(doneArg)
+	LCD_OP_FENCE,       ///< Wait until everything before is on the panel, then give the semaphore in ptr
+	LCD_OP_STOP,        ///< End of the service task
+} lcd_op_t;
+
+/**
+ * @brief A recorded drawing call
+ */
+typedef struct {
+	uint8_t op;           ///< lcd_op_t
+	uint16_t arg[8];      ///< Arguments of the call in their order, see lcd_op_t
+	const void *ptr;      ///< Colors or text of the call
+	FontxFile *font;
+	lcd_done_cb_t doneCb; ///< Completion of LCD_OP_PIXELS_DMA
+	void *doneArg;
+	lcd_rect_t bbox;      ///< Panel area the call may change
+} lcd_cmd_t;
+
+/**
+ * @brief Counters of the service task queue, see lcdStartService()
+ */
+typedef struct {
+	uint32_t queued;    ///< Calls other tasks put in the queue
+	uint32_t executed;  ///< Calls the service task ran
+	uint32_t depth;     ///< Calls waiting now
+	uint32_t maxDepth;  ///< Most calls seen waiting
+	uint32_t stalls;    ///< Calls that waited for room in a full queue
+	uint32_t inlineMiss; ///< Calls whose colors or text did not fit an entry, they waited until they ran
+} lcd_service_stats_t;
+
+struct lcd_service;
+
+/**
+ * @brief Band renderer state, see lcdSetBands()
+ */
+typedef struct {
+	lcd_framebuffer_t band[2]; ///< Stripe buffers, one is rendered while the other is on the wire
+	uint32_t bandSeq[2];       ///< _trans_done value at which a stripe buffer is free again
+	uint16_t bandHeight;
+	lcd_cmd_t *cmds;           ///< Calls recorded since lcdBeginFrame()
+	uint16_t cmdCount;
+	uint16_t cmdMax;
+	uint8_t *data;             ///< Copies of the colors and text of recorded calls
+	uint32_t dataUsed;
+	uint32_t dataLen;
+	uint16_t bgColor;          ///< Color of everything the frame does not draw
+	bool painted;              ///< A frame was sent, the fields below describe it
+	uint16_t paintedBg;
+	int16_t paintedY1;         ///< Rows the last frame drew in, empty when paintedY1 > paintedY2
+	int16_t paintedY2;
+} lcd_bands_t;
+
 typedef struct {
 	uint16_t _width;
 	uint16_t _height;
@@ -14,6 +235,7 @@ typedef struct {
 	uint16_t maxY;
 	uint16_t _offsetx;
 	uint16_t _offsety;
+	uint8_t _rotation;  ///< DIRECTION0..DIRECTION270 of lcdSetOrientation()
 	uint16_t _font_direction;
 	uint16_t _font_fill;
 	uint16_t _font_fill_color;
@@ -21,8 +243,61 @@ typedef struct {
 	uint16_t _font_underline_color;
 	int16_t _dc;
 	int16_t _bl;
-	uint16_t diplayBufferLen;
+	uint32_t diplayBufferLen;  ///< Bytes in each DMA buffer
 	spi_device_handle_t _SPIHandle;
+	lcd_dc_t _dc_mode[2];                          ///< Command and data D/C levels referenced by transactions
+	spi_transaction_t _trans[LCD_TRANS_QUEUE_LEN]; ///< Ring of queued transactions
+	lcd_done_cb_t _trans_cb[LCD_TRANS_QUEUE_LEN];  ///< Completion callbacks, called when a transaction is reaped
+	void *_trans_cb_arg[LCD_TRANS_QUEUE_LEN];
+	uint32_t _trans_queued;                        ///< Transactions queued since init
+	uint32_t _trans_done;                          ///< Transactions completed since init
+	uint8_t *_dma_buff[LCD_DMA_BUFF_MAX];          ///< Ring of DMA buffers for pixel data
+	uint32_t _dma_seq[LCD_DMA_BUFF_MAX];           ///< _trans_done value at which a buffer is free again
+	uint8_t _dma_count;                            ///< DMA buffers in the ring
+	uint8_t _dma_head;                             ///< Next DMA buffer to fill
+	uint32_t _chunk_len;                           ///< Bytes sent per buffered transaction, up to diplayBufferLen
+	uint32_t _max_transfer;                        ///< Bus max_transfer_sz, limit of a zero-copy transaction
+	int _clock_hz;                                 ///< SPI clock, used to size adaptive chunks
+	lcd_fill_t _fill[LCD_FILL_CACHE_MAX];          ///< Recently used fill colors
+	uint8_t _fill_count;
+	uint32_t _fill_clock;                          ///< LRU clock of the fill cache
+	lcd_glyph_t _glyph_cache[LCD_GLYPH_CACHE_MAX]; ///< Recently drawn glyphs of lcdDrawChar()
+	uint8_t _glyph_count;
+	uint32_t _glyph_clock;                         ///< LRU clock of the glyph cache
+	lcd_glyph_stats_t _glyph_stats;
+	uint16_t *_strip;                              ///< Text line of lcdDrawString(), sent as one window
+	uint32_t _strip_len;                           ///< Colors _strip holds, it grows with the longest line
+	uint32_t _strip_seq;                           ///< _trans_queued after the last line was queued
+	bool _strip_busy;                              ///< _strip is not sent yet
+	bool _win_valid;                               ///< Panel window matches the cached one below
+	uint16_t _win_x1;                              ///< Last CASET start column
+	uint16_t _win_x2;                              ///< Last CASET end column
+	uint16_t _win_y1;                              ///< Last RASET start row
+	uint16_t _win_y2;                              ///< Last RASET end row
+	uint32_t _win_pos;                             ///< Pixels written since the window start, i.e. the panel write pointer
+	lcd_window_stats_t _win_stats;
+	lcd_framebuffer_t _frame;                      ///< Full-frame buffer of lcdSetFramebuffer()
+	lcd_framebuffer_t *_fb;                        ///< Render target, NULL when drawing goes straight to the panel
+	lcd_bands_t *_bands;                           ///< Band renderer of lcdSetBands()
+	bool (*_capture)(void *dev, const lcd_cmd_t *cmd); ///< Takes drawing calls instead of running them, false to run the call
+	uint8_t _sync;                                 ///< lcd_sync_t
+	int16_t _te;                                   ///< TE input pin
+	SemaphoreHandle_t _te_sem;                     ///< Given on every vsync
+	volatile int64_t _te_time;                     ///< esp_timer time of the last vsync
+	volatile uint32_t _te_count;                   ///< Vsyncs since init
+	volatile uint32_t _frame_us;                   ///< Refresh period, measured between vsyncs
+	uint32_t _sync_vsyncs;                         ///< Vsync count at the last synchronized flush
+	int64_t _sync_time;                            ///< Time of the last synchronized flush, 0 before the first
+	lcd_frame_stats_t _frame_stats;
+	uint16_t _scroll_top;                          ///< First row of the hardware scroll area
+	uint16_t _scroll_height;                       ///< Rows of the scroll area, 0 when scrolling is off
+	uint16_t _scroll_pos;                          ///< Area line shown at its first row
+	struct lcd_service *_service;                  ///< Render task of lcdStartService(), NULL when calls run on the caller
+	spi_host_device_t _host;
+	SemaphoreHandle_t _lock;                       ///< Recursive mutex of lcdLock(), NULL without display_config_t.locking
+	uint8_t _dots[LCD_FONT_GLYPH_LEN];             ///< Glyph bitmap read from the font file
+	uint16_t _glyph[LCD_GLYPH_PIXELS];             ///< Glyph colors for display write
+	lcd_point_t _glyphPoints[LCD_GLYPH_PIXELS];    ///< Set glyph pixels of lcdDrawCharS(), drawn as a pixel batch
 } TFT_t;
 
 typedef struct {
@@ -35,6 +310,15 @@ typedef struct {
     gpio_num_t pinRESET;
     gpio_num_t pinBL;
 	spi_host_device_t spiHost;
+	uint32_t bufferSize;      ///< Bytes in each DMA buffer, 0 for the default
+	uint8_t bufferCount;      ///< DMA buffers in flight (2..LCD_DMA_BUFF_MAX), 0 for the default
+	uint32_t maxTransferSize; ///< Bus max_transfer_sz in bytes, 0 for the default
+	bool adaptiveChunk;       ///< Size chunks from the measured per-transaction overhead instead of using whole buffers
+	uint8_t fillCacheSize;    ///< Fill colors kept as ready DMA patterns (1..LCD_FILL_CACHE_MAX), 0 for the default
+	uint8_t glyphCacheSize;   ///< Glyphs kept rendered in their colors (up to LCD_GLYPH_CACHE_MAX), 0 for none
+	uint8_t frameSync;        ///< lcd_sync_t, LCD_SYNC_NONE by default
+	gpio_num_t pinTE;         ///< Tearing effect output of the panel, used with LCD_SYNC_TE_PIN
+	bool locking;             ///< Serialize calls of several tasks with a per-device mutex
 } display_config_t;
 
 typedef struct {
@@ -47,9 +331,17 @@ typedef struct {
 } mad_ctl_t;
 
 void lcdInit(TFT_t *dev, display_config_t *display_config, spi_device_interface_config_t *spiInterfaceConfig);
+void lcdDeinit(TFT_t *dev);
+void lcdLock(TFT_t *dev);
+void lcdUnlock(TFT_t *dev);
 void lcdDrawPixel(TFT_t * dev, uint16_t x, uint16_t y, uint16_t color);
 void lcdDrawPixels(TFT_t * dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *pixels, uint16_t size);
+void lcdDrawPixelsDMA(TFT_t *dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels, lcd_done_cb_t doneCb, void *arg);
+void lcdDrawPixelsDMAWait(TFT_t *dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, const uint16_t *pixels);
+void lcdWaitDone(TFT_t *dev);
+void lcdPollDone(TFT_t *dev);
 void lcdDrawFillRect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t width, uint16_t height, uint16_t color);
+void lcdDrawPixelBatch(TFT_t *dev, lcd_point_t *points, uint16_t *colors, uint16_t n);
 void lcdDisplayOff(TFT_t * dev);
 void lcdDisplayOn(TFT_t * dev);
 void lcdFillScreen(TFT_t * dev, uint16_t color);
@@ -58,18 +350,31 @@ void lcdDrawHLineT(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t length, uint1
 void lcdDrawVLine(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t height, uint16_t color);
 void lcdDrawVLineT(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t height, uint16_t b, uint16_t color);
 void lcdDrawLine(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t color);
+void lcdDrawLineT(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t b, uint16_t color);
+void lcdDrawPolyline(TFT_t *dev, const lcd_point_t *points, uint16_t count, uint16_t b, uint8_t style, uint16_t color);
 void lcdDrawRect(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t width, uint16_t height, uint16_t color);
 void lcdDrawRectT(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t width, uint16_t height, uint16_t b, uint16_t color);
 void lcdDrawRectAngle(TFT_t * dev, uint16_t xc, uint16_t yc, uint16_t w, uint16_t h, uint16_t angle, uint16_t color);
 void lcdDrawTriangle(TFT_t * dev, uint16_t xc, uint16_t yc, uint16_t w, uint16_t h, uint16_t angle, uint16_t color);
+void lcdDrawFillTriangle(TFT_t * dev, uint16_t xc, uint16_t yc, uint16_t w, uint16_t h, uint16_t angle, uint16_t color);
+void lcdDrawFillPolygon(TFT_t *dev, const lcd_point_t *points, uint16_t count, uint16_t color);
 void lcdDrawCircle(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color);
 void lcdDrawFillCircle(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t color);
+void lcdLineSpans(int x1, int y1, int x2, int y2, uint16_t color, lcd_span_sink_t sink, void *ctx);
+void lcdCircleSpans(int x0, int y0, uint16_t r, uint16_t color, lcd_span_sink_t sink, void *ctx);
+void lcdFillCircleSpans(int x0, int y0, uint16_t r, uint16_t color, lcd_span_sink_t sink, void *ctx);
 void lcdDrawRoundRect(TFT_t * dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t r, uint16_t color);
+void lcdDrawFillRoundRect(TFT_t *dev, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t r, uint16_t color);
+void lcdDrawArc(TFT_t *dev, uint16_t x0, uint16_t y0, uint16_t r, uint16_t thickness, uint16_t startAngle, uint16_t endAngle, uint16_t color);
 void lcdDrawArrow(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t w, uint16_t color);
 void lcdDrawFillArrow(TFT_t * dev, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t w, uint16_t color);
+void lcdExpandGlyph(const uint8_t *bits, uint8_t pw, uint8_t ph, uint16_t fg, uint16_t bg, bool swapped,
+                    uint16_t *dst, uint16_t stride);
 uint8_t  lcdDrawChar(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t charCode, uint16_t color, uint16_t bgColor);
+uint8_t  lcdDrawCharS(TFT_t *dev, FontxFile *fxs, uint16_t x, uint16_t y, uint8_t charCode, uint16_t color);
 uint16_t lcdDrawString(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor);
 uint16_t lcdDrawStringS(TFT_t * dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color);
+uint16_t lcdDrawStringPadded(TFT_t *dev, FontxFile *fx, uint16_t x, uint16_t y, char *str, uint16_t color, uint16_t bgColor, uint16_t width);
 void lcdSetFontDirection(TFT_t * dev, uint16_t);
 void lcdSetFontFill(TFT_t * dev, uint16_t color);
 void lcdUnsetFontFill(TFT_t * dev);
@@ -80,5 +385,33 @@ void lcdBacklightOn(TFT_t * dev);
 void lcdInversionOff(TFT_t * dev);
 void lcdInversionOn(TFT_t * dev);
 esp_err_t lcdReadMemoryDataAccessControl(TFT_t *dev, mad_ctl_t *mad_ctl);
+uint16_t lcdReadRegion(TFT_t *dev, uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t *colors);
+esp_err_t lcdSetOrientation(TFT_t *dev, uint8_t rotation);
+esp_err_t lcdSetFramebuffer(TFT_t *dev, uint16_t *pixels);
+void lcdUnsetFramebuffer(TFT_t *dev);
+void lcdFlush(TFT_t *dev);
+void lcdFlushAsync(TFT_t *dev);
+esp_err_t lcdSetBands(TFT_t *dev, uint16_t bandHeight, uint16_t maxCommands, uint32_t dataBytes);
+void lcdUnsetBands(TFT_t *dev);
+void lcdBeginFrame(TFT_t *dev, uint16_t bgColor);
+void lcdEndFrame(TFT_t *dev);
+esp_err_t lcdSetScrollArea(TFT_t *dev, uint16_t top, uint16_t height);
+void lcdScrollTo(TFT_t *dev, uint16_t line);
+esp_err_t lcdWaitVsync(TFT_t *dev, uint32_t timeoutMs);
+int lcdGetScanline(TFT_t *dev);
+void lcdFlushSynced(TFT_t *dev);
+void lcdGetFrameStats(TFT_t *dev, lcd_frame_stats_t *stats);
+void lcdResetFrameStats(TFT_t *dev);
+esp_err_t lcdStartService(TFT_t *dev, uint16_t queueLen, UBaseType_t priority, BaseType_t core);
+void lcdStopService(TFT_t *dev);
+void lcdServiceCall(TFT_t *dev, lcd_done_cb_t fn, void *arg);
+void lcdGetServiceStats(TFT_t *dev, lcd_service_stats_t *stats);
+void lcdResetServiceStats(TFT_t *dev);
+void lcdGetWindowStats(TFT_t *dev, lcd_window_stats_t *stats);
+void lcdResetWindowStats(TFT_t *dev);
+void lcdClearGlyphCache(TFT_t *dev);
+void lcdGetGlyphStats(TFT_t *dev, lcd_glyph_stats_t *stats);
+void lcdResetGlyphStats(TFT_t *dev);
 uint16_t rgb565_conv(uint16_t r, uint16_t g, uint16_t b);
 uint16_t rgb24to16(uint32_t color);
+#endif /* MAIN_ST7789_H_ */
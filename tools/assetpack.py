@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""
+Build an asset pack for a flash partition, read at run time with lcdAssetsOpen() (main/assets.h).
+
+    python3 tools/assetpack.py -o assets.bin --size 0x4000 font/ images/logo.bmp ...
+
+Directories are packed with every file they hold. Each blob is looked up by its file name:
+  .fnt  FONTX2 font, stored as it is, see lcdAssetsInitFont()
+  .bmp  24 or 32 bit uncompressed bitmap, converted to big-endian RGB565, see lcdAssetsBitmap()
+  .pal  RGB888 triplets, converted to big-endian RGB565 like the bitmaps
+  other files are stored as they are
+
+Layout, little-endian:
+  header   "AST1", slots, count, size
+  index    slots entries of hash, name offset, blob offset, blob size, type (offset 0: free)
+  names    zero-terminated
+  blobs    each starting on a 16 byte boundary
+A name goes to slot hash % slots, or the next free one; slots is a power of two at least
+twice the count, so lookups stay short.
+"""
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = b'AST1'
+ALIGN = 16
+HEADER = struct.Struct('<4sIII')
+ENTRY = struct.Struct('<IIIII')
+
+TYPE_RAW = 0
+TYPE_FONT = 1
+TYPE_BITMAP = 2
+TYPE_PALETTE = 3
+
+
+def fnv1a(name):
+    h = 2166136261
+    for b in name.encode('utf-8'):
+        h = ((h ^ b) * 16777619) & 0xffffffff
+    return h
+
+
+def rgb565(r, g, b):
+    return ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3)
+
+
+def convert_bmp(path, data):
+    if data[0:2] != b'BM' or len(data) < 54:
+        sys.exit('%s: not a BMP file' % path)
+    offset, = struct.unpack_from('<I', data, 10)
+    width, height, planes, bpp, compression = struct.unpack_from('<iiHHI', data, 18)
+    if bpp not in (24, 32) or compression not in (0, 3):
+        sys.exit('%s: only uncompressed 24 or 32 bit bitmaps are supported' % path)
+    bottom_up = height > 0
+    height = abs(height)
+    if width <= 0 or width > 0xffff or height > 0xffff:
+        sys.exit('%s: bad size %dx%d' % (path, width, height))
+    step = bpp // 8
+    stride = (width * step + 3) & ~3
+    if offset + stride * height > len(data):
+        sys.exit('%s: truncated' % path)
+    out = bytearray(struct.pack('<HH', width, height))
+    for y in range(height):
+        row = offset + stride * (height - 1 - y if bottom_up else y)
+        for x in range(width):
+            b, g, r = data[row + x * step:row + x * step + 3]
+            # In the byte order of the wire, for lcdDrawPixelsDMA()
+            out += struct.pack('>H', rgb565(r, g, b))
+    return bytes(out)
+
+
+def convert_palette(path, data):
+    if len(data) % 3:
+        sys.exit('%s: not a list of RGB888 colors' % path)
+    return b''.join(struct.pack('>H', rgb565(*data[i:i + 3])) for i in range(0, len(data), 3))
+
+
+def load(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    ext = os.path.splitext(path)[1].lower()
+    if ext == '.fnt':
+        if data[0:6] != b'FONTX2':
+            sys.exit('%s: not a FONTX2 file' % path)
+        return TYPE_FONT, data
+    if ext == '.bmp':
+        return TYPE_BITMAP, convert_bmp(path, data)
+    if ext == '.pal':
+        return TYPE_PALETTE, convert_palette(path, data)
+    return TYPE_RAW, data
+
+
+def collect(paths):
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            for name in sorted(os.listdir(path)):
+                full = os.path.join(path, name)
+                if os.path.isfile(full):
+                    files.append(full)
+        else:
+            files.append(path)
+    return files
+
+
+def align(n):
+    return (n + ALIGN - 1) // ALIGN * ALIGN
+
+
+def build(files):
+    assets = []
+    for path in files:
+        name = os.path.basename(path)
+        if any(a['name'] == name for a in assets):
+            sys.exit('%s: two files named %s' % (path, name))
+        kind, blob = load(path)
+        assets.append({'name': name, 'hash': fnv1a(name), 'type': kind, 'blob': blob})
+
+    slots = 2
+    while slots < 2 * len(assets):
+        slots *= 2
+
+    names = bytearray()
+    pos = HEADER.size + slots * ENTRY.size
+    for a in assets:
+        a['name_offset'] = pos + len(names)
+        names += a['name'].encode('utf-8') + b'\0'
+    pos = align(pos + len(names))
+    for a in assets:
+        a['offset'] = pos
+        pos = align(pos + len(a['blob']))
+    size = pos
+
+    index = [None] * slots
+    for a in assets:
+        slot = a['hash'] % slots
+        while index[slot] is not None:
+            slot = (slot + 1) % slots
+        index[slot] = a
+
+    out = bytearray(HEADER.pack(MAGIC, slots, len(assets), size))
+    for a in index:
+        if a is None:
+            out += ENTRY.pack(0, 0, 0, 0, 0)
+        else:
+            out += ENTRY.pack(a['hash'], a['name_offset'], a['offset'], len(a['blob']), a['type'])
+    out += names
+    for a in assets:
+        out += bytes(a['offset'] - len(out))
+        out += a['blob']
+    out += bytes(size - len(out))
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Build an asset pack for a flash partition')
+    parser.add_argument('-o', '--output', required=True, help='image to write')
+    parser.add_argument('--size', type=lambda s: int(s, 0), help='partition size to check the pack against')
+    parser.add_argument('inputs', nargs='+', help='files and directories to pack')
+    args = parser.parse_args()
+
+    pack = build(collect(args.inputs))
+    if args.size is not None and len(pack) > args.size:
+        sys.exit('pack of %d bytes does not fit the partition of %d bytes' % (len(pack), args.size))
+    with open(args.output, 'wb') as f:
+        f.write(pack)
+
+
+if __name__ == '__main__':
+    main()
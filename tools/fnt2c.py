@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""
+Convert FONTX2 .fnt files into const C arrays, so fonts live in flash and need no file system.
+
+    python3 tools/fnt2c.py -o fonts_embedded.c --header fonts_embedded.h font/font10x20-KOI8-R.fnt ...
+
+Each font becomes a FontxEmbedded named fontx_<file name>, with every character that is not a
+letter or digit replaced by '_', e.g. fontx_font10x20_KOI8_R. Pass it to InitFontxEmbedded().
+"""
+import argparse
+import os
+import re
+import sys
+
+HEADER_LEN = 17         # Signature, name, width, height and code flag of an ANK font
+GLYPH_BUF_SIZE = 32 * 32 // 8   # FontxGlyphBufSize of fontx.h
+
+
+def symbol(path):
+    base = os.path.splitext(os.path.basename(path))[0]
+    return 'fontx_' + re.sub(r'[^0-9A-Za-z]', '_', base)
+
+
+def read_font(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) < HEADER_LEN + 1 or data[0:6] != b'FONTX2':
+        sys.exit('%s: not a FONTX2 file' % path)
+    w, h, code = data[14], data[15], data[16]
+    if code != 0:
+        sys.exit('%s: only ANK (single-byte) fonts are supported' % path)
+    fsz = (w + 7) // 8 * h
+    if fsz > GLYPH_BUF_SIZE:
+        sys.exit('%s: %dx%d glyphs are larger than FontxGlyphBufSize' % (path, w, h))
+    glyphs = data[HEADER_LEN:HEADER_LEN + 256 * fsz]
+    if len(glyphs) < 256 * fsz:
+        # Missing glyphs at the end stay blank
+        glyphs += bytes(256 * fsz - len(glyphs))
+    name = data[6:14].split(b'\0')[0].decode('ascii', 'replace')
+    return {
+        'path': path,
+        'symbol': symbol(path),
+        'name': name,
+        'w': w,
+        'h': h,
+        'fsz': fsz,
+        'bc': data[17] if len(data) > 17 else 0,
+        'glyphs': glyphs,
+    }
+
+
+def c_string(s):
+    return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+
+def write_source(fonts, out, header):
+    lines = [
+        '// Generated by tools/fnt2c.py, do not edit',
+        '#include <stdio.h>',
+        '#include <stdint.h>',
+        '#include <stdbool.h>',
+        '',
+        '#include "%s"' % os.path.basename(header),
+        '',
+    ]
+    for font in fonts:
+        glyphs = font['glyphs']
+        lines.append('// %s, %dx%d' % (os.path.basename(font['path']), font['w'], font['h']))
+        lines.append('static const uint8_t %s_glyphs[%d] = {' % (font['symbol'], len(glyphs)))
+        for i in range(0, len(glyphs), 16):
+            lines.append('\t' + ' '.join('0x%02x,' % b for b in glyphs[i:i + 16]))
+        lines.append('};')
+        lines.append('')
+        lines.append('const FontxEmbedded %s = {' % font['symbol'])
+        lines.append('\t.name = %s,' % c_string(os.path.basename(font['path'])))
+        lines.append('\t.fxname = %s,' % c_string(font['name']))
+        lines.append('\t.is_ank = true,')
+        lines.append('\t.w = %d,' % font['w'])
+        lines.append('\t.h = %d,' % font['h'])
+        lines.append('\t.fsz = %d,' % font['fsz'])
+        lines.append('\t.bc = %d,' % font['bc'])
+        lines.append('\t.glyphs = %s_glyphs,' % font['symbol'])
+        lines.append('};')
+        lines.append('')
+    write_file(out, '\n'.join(lines))
+
+
+def write_header(fonts, header):
+    guard = re.sub(r'[^0-9A-Za-z]', '_', os.path.basename(header)).upper() + '_'
+    lines = [
+        '// Generated by tools/fnt2c.py, do not edit',
+        '#ifndef %s' % guard,
+        '#define %s' % guard,
+        '#include <stdio.h>',
+        '#include <stdint.h>',
+        '#include <stdbool.h>',
+        '#include "fontx.h"',
+        '',
+    ]
+    for font in fonts:
+        lines.append('extern const FontxEmbedded %s;' % font['symbol'])
+    lines.append('#endif /* %s */' % guard)
+    lines.append('')
+    write_file(header, '\n'.join(lines))
+
+
+def write_file(path, text):
+    with open(path, 'w') as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Convert FONTX2 fonts into C arrays')
+    parser.add_argument('-o', '--output', required=True, help='C source to write')
+    parser.add_argument('--header', required=True, help='header with the declarations to write')
+    parser.add_argument('fonts', nargs='+', help='.fnt files')
+    args = parser.parse_args()
+
+    fonts = [read_font(path) for path in args.fonts]
+    symbols = [font['symbol'] for font in fonts]
+    for s in symbols:
+        if symbols.count(s) > 1:
+            sys.exit('two fonts map to %s' % s)
+    write_header(fonts, args.header)
+    write_source(fonts, args.output, args.header)
+
+
+if __name__ == '__main__':
+    main()
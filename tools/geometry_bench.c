@@ -0,0 +1,116 @@
+/*
+ * Host check of the fixed-point geometry in main/geometry.c against the double-precision
+ * code it replaced: largest corner deviation in pixels and time per call.
+ *
+ *   cc -O2 -Imain tools/geometry_bench.c main/geometry.c -lm -o geometry_bench
+ *   ./geometry_bench
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "geometry.h"
+
+#define RUNS 2000000
+
+static volatile int32_t sink;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// lcdDrawRectAngle() and lcdDrawTriangle() corners before geoRotate()
+static void rotate_double(int32_t x, int32_t y, int32_t angle, int32_t xc, int32_t yc, int32_t *rx, int32_t *ry)
+{
+    double rd = -angle * M_PI / 180.0;
+    *rx = (int)(x * cos(rd) - y * sin(rd) + xc);
+    *ry = (int)(x * sin(rd) + y * cos(rd) + yc);
+}
+
+// lcdDrawArrow() base corners before geoArrowBase()
+static void arrow_double(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t w, int32_t *L, int32_t *R)
+{
+    double Vx = x1 - x0;
+    double Vy = y1 - y0;
+    double v = sqrt(Vx*Vx+Vy*Vy);
+    double Ux = Vx/v;
+    double Uy = Vy/v;
+    L[0] = (int)(x1 - Uy*w - Ux*v);
+    L[1] = (int)(y1 + Ux*w - Uy*v);
+    R[0] = (int)(x1 + Uy*w - Ux*v);
+    R[1] = (int)(y1 - Ux*w - Uy*v);
+}
+
+int main(void)
+{
+    int32_t ax, ay, bx, by;
+    int32_t L[2], R[2], L2[2], R2[2];
+    long rotations = 0, rotationsOff = 0, arrows = 0, arrowsOff = 0;
+    int rotationMax = 0, arrowMax = 0;
+
+    for (int angle = 0; angle < 360; angle++) {
+        for (int x = -160; x <= 160; x += 3) {
+            for (int y = -160; y <= 160; y += 7) {
+                rotate_double(x, y, angle, 120, 160, &ax, &ay);
+                geoRotate(x, y, angle, 120, 160, &bx, &by);
+                int d = abs(ax - bx) > abs(ay - by) ? abs(ax - bx) : abs(ay - by);
+                if (d > rotationMax) rotationMax = d;
+                if (d) rotationsOff++;
+                rotations++;
+            }
+        }
+    }
+
+    srand(1);
+    for (int i = 0; i < 200000; i++) {
+        int x0 = rand() % 320, y0 = rand() % 320, x1 = rand() % 320, y1 = rand() % 320, w = rand() % 40 + 1;
+        if (x0 == x1 && y0 == y1) continue;
+        arrow_double(x0, y0, x1, y1, w, L, R);
+        geoArrowBase(x0, y0, x1, y1, w, L2, R2);
+        int d = 0;
+        for (int k = 0; k < 2; k++) {
+            if (abs(L[k] - L2[k]) > d) d = abs(L[k] - L2[k]);
+            if (abs(R[k] - R2[k]) > d) d = abs(R[k] - R2[k]);
+        }
+        if (d > arrowMax) arrowMax = d;
+        if (d) arrowsOff++;
+        arrows++;
+    }
+
+    printf("rotation: %ld points, %ld off, max deviation %d px\n", rotations, rotationsOff, rotationMax);
+    printf("arrow:    %ld bases, %ld off, max deviation %d px\n", arrows, arrowsOff, arrowMax);
+
+    double t = now();
+    for (int i = 0; i < RUNS; i++) {
+        rotate_double(i & 63, 40, i % 360, 120, 160, &ax, &ay);
+        sink = ax + ay;
+    }
+    double rotateDouble = (now() - t) / RUNS * 1e9;
+    t = now();
+    for (int i = 0; i < RUNS; i++) {
+        geoRotate(i & 63, 40, i % 360, 120, 160, &ax, &ay);
+        sink = ax + ay;
+    }
+    double rotateFixed = (now() - t) / RUNS * 1e9;
+    t = now();
+    for (int i = 0; i < RUNS; i++) {
+        arrow_double(10, 20, 200 + (i & 63), 150, 8, L, R);
+        sink = L[0] + R[1];
+    }
+    double arrowDouble = (now() - t) / RUNS * 1e9;
+    t = now();
+    for (int i = 0; i < RUNS; i++) {
+        geoArrowBase(10, 20, 200 + (i & 63), 150, 8, L, R);
+        sink = L[0] + R[1];
+    }
+    double arrowFixed = (now() - t) / RUNS * 1e9;
+
+    printf("rotation: double %.1f ns, fixed %.1f ns\n", rotateDouble, rotateFixed);
+    printf("arrow:    double %.1f ns, fixed %.1f ns\n", arrowDouble, arrowFixed);
+    return 0;
+}